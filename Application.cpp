@@ -24,6 +24,21 @@ std::random_device rd;
 std::mt19937 gen(rd());
 std::uniform_real_distribution<> dis(0.2, 0.8);
 
+// Placed blocks stand out in yellow, terrain gets a random shade of green
+static glm::vec3 blockColor(BlockId id)
+{
+  if (id == BLOCK_PLACED)
+  {
+    return glm::vec3(0.9f, 0.9f, 0.2f);
+  }
+  return glm::vec3(0.0f, dis(gen), 0.0f);
+}
+
+static glm::vec3 chunkCenter(ChunkCoord coord)
+{
+  return (glm::vec3(coord.x, coord.y, coord.z) + glm::vec3(0.5f)) * static_cast<float>(CHUNK_SIZE);
+}
+
 // Model, View, and Projection Transformations to the input vertex position
 const char *vertexShaderSource = R"(
     #version 330 core
@@ -66,7 +81,8 @@ Application::Application()
     : gameRunning(true), frameCount(0), timeDifference(0), frameAverage(0),
       cameraPos(0.0f, 0.0f, 3.0f), cameraFront(0.0f, 0.0f, -1.0f), cameraUp(0.0f, 1.0f, 0.0f),
       yaw(-90.0f), pitch(0.0f), debugMode(true), window(nullptr), glContext(nullptr), lastX(SCREEN_WIDTH / 2.0f), lastY(SCREEN_HEIGHT / 2.0f),
-      mouseSensitivity(0.1f), firstMouse(true)
+      mouseSensitivity(0.1f), firstMouse(true), transformsUpdated(0), capture(resources), player(NULL_ENTITY),
+      lastUpdateCounter(0), serverPort(0), lookHitValid(false), farTerrainDirty(false)
 {
   //std::cout << "Application Created\n";
 #ifdef _WIN32
@@ -84,17 +100,6 @@ Application::~Application()
   //std::cout << "Application Destroyed\n";
   clean();
 }
-double Application::easeInOutExpo(double x) {
-    if (x == 0.0) {
-        return 0.0;
-    } else if (x == 1.0) {
-        return 1.0;
-    } else if (x < 0.5) {
-        return std::pow(2, 20 * x - 10) / 2;
-    } else {
-        return (2 - std::pow(2, -20 * x + 10)) / 2;
-    }
-}
 bool Application::init()
 {
   try
@@ -183,30 +188,24 @@ bool Application::init()
     ImGui_ImplOpenGL3_Init("#version 330");
 
     //std::cout << "Render complete." << std::endl;
-    //cubes.reserve(2); // Reserve 2 cubes
-
-
-    int i = 0;
-    for (int x = 0; x < terrain5ChunkX; x++) {
-        for (int z = 0; z < terrain5ChunkZ; z++) {
-            // Scale y input to [0, 1] range
-            double normalizedY = static_cast<double>(z)/ (terrain5ChunkZ - 1);
-            // Apply easing function
-            double easedY = easeInOutExpo(normalizedY);
-            // Scale the eased value to a more noticeable height (e.g., 0 to 10)
-            double scaledY = easedY * 10.0;
-            std::cout << "!!! EASE " << scaledY << std::endl;
-            int roundedY = static_cast<int>(std::round(scaledY));
-            cubes.emplace_back(
-                Cube(i,
-                    glm::vec3(x, roundedY, -z),  // Use scaledY for height
-                    glm::vec3(0.0f),
-                    glm::vec3(1.0f),
-                    glm::vec3(0, dis(gen), 0)));
-            i++;
-        }
-    }
+    resources.setBudget(ResourceCategory::GLBuffers, glBufferBudget);
+    resources.setBudget(ResourceCategory::ChunkData, chunkDataBudget);
+    // Cube ids are their slot in cubes, chunk keys index chunkKeys
+    resources.setEvictCallback(ResourceCategory::GLBuffers, [this](uint32_t key) { cubes[key]->releaseMesh(); });
+    // Chunks are only touched when their data arrives, so recency says nothing about use, go by distance
+    resources.setEvictCallback(ResourceCategory::ChunkData, [this](uint32_t key) { evictChunk(key); },
+                               EvictionOrder::Farthest);
+
 
+    // Terrain comes from the world server, in process or headless
+    connectWorld();
+
+    // Terrain cubes and the octree come from the snapshots that arrived while connecting
+    applyWorldChanges();
+
+    // Player, enemies and dynamic props live in the entity registry
+    spawnEntities();
+    lastUpdateCounter = SDL_GetPerformanceCounter();
 
     //std::cout << "Initialization complete." << std::endl;
     gameRunning = true;
@@ -228,6 +227,7 @@ void Application::render()
     //std::cout << "Starting render..." << std::endl;
 
     //std::cout << "Render method started, number of cubes: " << cubes.size() << std::endl;
+    resources.beginFrame(cameraPos);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     //std::cout << "Using shader program..." << std::endl;
@@ -235,7 +235,7 @@ void Application::render()
 
     //std::cout << "Creating matrices..." << std::endl;
     glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, farPlane);
 
     //std::cout << "Getting uniform locations..." << std::endl;
     GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
@@ -253,8 +253,11 @@ void Application::render()
 
     // Draw cubes here
     for (auto &cube : cubes) {
-        glm::mat4 model = cube.getModelMatrix();
-        glm::vec3 color = cube.getColor();
+        if (!cube) {
+            continue;
+        }
+        const glm::mat4 &model = cube->getModelMatrix();
+        glm::vec3 color = cube->getColor();
         // Set the color uniform
         GLint colorLoc = glGetUniformLocation(shaderProgram, "cubeColor");
         if (colorLoc != -1) {
@@ -263,8 +266,13 @@ void Application::render()
             std::cerr << "Warning: cubeColor uniform not found in shader program" << std::endl;
         }
         glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        cube.draw();
+        cube->draw();
     }
+
+    // Read the scene back before the debug UI is drawn over it
+    int drawableWidth, drawableHeight;
+    SDL_GL_GetDrawableSize(window, &drawableWidth, &drawableHeight);
+    capture.captureFrame(drawableWidth, drawableHeight);
     //std::cout << "Starting ImGui rendering..." << std::endl;
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplSDL2_NewFrame();
@@ -273,7 +281,22 @@ void Application::render()
     ImGui::Begin("Debug");
     ImGui::Text("Camera Position: (%.2f, %.2f, %.2f)", cameraPos.x, cameraPos.y, cameraPos.z);
     ImGui::Text("Yaw: %.2f, Pitch: %.2f", yaw, pitch);
+    ImGui::Text("Transforms rebuilt: %zu / %zu", transformsUpdated, transforms.size());
+    ImGui::Text("World: %zu chunks, %.1f KB received", client->getWorld().chunkCount(),
+                client->getBytesReceived() / 1024.0f);
+    ImGui::Text("Octree: %zu nodes, %.1f KB, %zu far boxes", octree.nodeCount(), octree.memoryBytes() / 1024.0f,
+                farCubes.size());
+    if (lookHitValid)
+    {
+      ImGui::Text("Looking at: (%d, %d, %d) %.1f away", lookHit.x, lookHit.y, lookHit.z, lookHit.distance);
+    }
+    if (capture.isActive())
+    {
+      ImGui::Text("Capturing: %zu written, %zu dropped, %.3f ms/frame", capture.getFramesWritten(),
+                  capture.getFramesDropped(), capture.getLastCaptureMs());
+    }
     ImGui::End();
+    resources.drawDebugPanel();
 
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -281,6 +304,9 @@ void Application::render()
     //std::cout << "Swapping window..." << std::endl;
     SDL_GL_SwapWindow(window);
 
+    // Evict over budget meshes and issue this frame's batched deletions
+    resources.endFrame();
+
     //std::cout << "Render complete." << std::endl;
 
   }
@@ -368,6 +394,27 @@ void Application::handleEvents()
       case SDLK_LCTRL:
         cameraPos -= cameraUp * cameraSpeed;
         break;
+      case SDLK_b:
+      {
+        // Ask the server for a block against the face being looked at,
+        // or a few units in front of the camera when looking at nothing
+        if (lookHitValid)
+        {
+          client->requestSetBlock(lookHit.prevX, lookHit.prevY, lookHit.prevZ, BLOCK_PLACED);
+          break;
+        }
+        glm::vec3 target = cameraPos + cameraFront * 3.0f;
+        client->requestSetBlock(static_cast<int>(std::floor(target.x + 0.5f)),
+                                static_cast<int>(std::floor(target.y + 0.5f)),
+                                static_cast<int>(std::floor(target.z + 0.5f)), BLOCK_PLACED);
+        break;
+      }
+      case SDLK_F12:
+        toggleCapture(CaptureFormat::PNG);
+        break;
+      case SDLK_F11:
+        toggleCapture(CaptureFormat::Raw);
+        break;
       }
     }
   }
@@ -375,20 +422,460 @@ void Application::handleEvents()
 
 void Application::update()
 {
-  // Update game logic here
-  for (auto &cube : cubes)
+  // Frame delta for the entity systems
+  Uint64 now = SDL_GetPerformanceCounter();
+  float dt = (now - lastUpdateCounter) / (float)SDL_GetPerformanceFrequency();
+  lastUpdateCounter = now;
+  // Clamp so a long stall (window drag, breakpoint) doesn't fling everything away
+  if (dt > 0.1f)
+  {
+    dt = 0.1f;
+  }
+
+  // Player follows the camera
+  if (registry.valid(player))
+  {
+    registry.get<Position>(player).value = cameraPos;
+  }
+
+  // World replication
+  client->updateCamera(cameraPos.x, cameraPos.y, cameraPos.z);
+  if (server)
+  {
+    server->tick();
+  }
+  client->poll();
+  applyWorldChanges();
+  updateLookHit();
+
+  updateEnemies();
+  integrateMotion(dt);
+  bounceProps();
+  syncCubes();
+
+  // Only cubes that moved this frame get new model matrices
+  transformsUpdated = transforms.update();
+}
+
+void Application::connectWorld()
+{
+  std::unique_ptr<Transport> clientTransport;
+  if (serverPort == 0)
+  {
+    // In process server over a loopback pair
+    std::unique_ptr<Transport> serverTransport;
+    LoopbackTransport::createPair(clientTransport, serverTransport);
+    server.reset(new WorldServer());
+    server->generateTerrain(terrain5ChunkX, terrain5ChunkZ, TERRAIN_MAX_HEIGHT);
+    server->addClient(std::move(serverTransport));
+  }
+  else
+  {
+    clientTransport = SocketTransport::connect("127.0.0.1", serverPort);
+    if (!clientTransport)
+    {
+      throw std::runtime_error("Could not connect to world server on port " + std::to_string(serverPort));
+    }
+  }
+  client.reset(new WorldClient(std::move(clientTransport)));
+  client->subscribe(cameraPos.x, cameraPos.y, cameraPos.z, interestRadius);
+
+  // Wait for the initial snapshots
+  Uint64 start = SDL_GetTicks64();
+  while (!client->isSynced())
+  {
+    if (server)
+    {
+      server->tick();
+    }
+    client->poll();
+    if (!client->isConnected() || SDL_GetTicks64() - start > worldSyncTimeoutMs)
+    {
+      throw std::runtime_error("World server did not send the initial chunks");
+    }
+    if (!client->isSynced() && !server)
+    {
+      SDL_Delay(1);
+    }
+  }
+}
+
+// Keep the cubes and the octree in step with the replica, whole chunks on snapshots and unloads,
+// single blocks on deltas
+void Application::applyWorldChanges()
+{
+  std::vector<WorldClient::ChunkEvent> events;
+  client->takeChunkEvents(events);
+  for (size_t i = 0; i < events.size(); i++)
+  {
+    if (events[i].loaded)
+    {
+      loadChunk(events[i].coord);
+    }
+    else
+    {
+      unloadChunk(events[i].coord);
+    }
+  }
+
+  std::vector<WorldClient::BlockChange> changes;
+  client->takeChanges(changes);
+  std::vector<ChunkCoord> changedChunks;
+  for (size_t i = 0; i < changes.size(); i++)
+  {
+    const WorldClient::BlockChange &change = changes[i];
+    refreshBlock(change.x, change.y, change.z);
+    // The block below may have been covered or uncovered
+    refreshBlock(change.x, change.y - 1, change.z);
+
+    ChunkCoord coord = {chunkFloor(change.x), chunkFloor(change.y), chunkFloor(change.z)};
+    std::unordered_map<ChunkCoord, LoadedChunk, ChunkCoordHash>::iterator loaded = loadedChunks.find(coord);
+    if (loaded != loadedChunks.end())
+    {
+      resources.touch(ResourceCategory::ChunkData, loaded->second.key, chunkCenter(coord));
+      if (std::find(changedChunks.begin(), changedChunks.end(), coord) == changedChunks.end())
+      {
+        changedChunks.push_back(coord);
+      }
+    }
+  }
+  // One octree path per edited chunk, however many blocks changed in it
+  for (size_t i = 0; i < changedChunks.size(); i++)
+  {
+    octree.updateChunk(client->getWorld(), changedChunks[i]);
+  }
+
+  if (farTerrainDirty)
+  {
+    updateFarTerrain();
+  }
+}
+
+void Application::loadChunk(ChunkCoord coord)
+{
+  // Unloaded again later in the same batch
+  if (!client->getWorld().getChunk(coord))
+  {
+    return;
+  }
+  std::unordered_map<ChunkCoord, LoadedChunk, ChunkCoordHash>::iterator loaded = loadedChunks.find(coord);
+  if (loaded == loadedChunks.end())
+  {
+    uint32_t key;
+    if (!freeChunkKeys.empty())
+    {
+      key = freeChunkKeys.back();
+      freeChunkKeys.pop_back();
+      chunkKeys[key] = coord;
+    }
+    else
+    {
+      key = static_cast<uint32_t>(chunkKeys.size());
+      chunkKeys.push_back(coord);
+    }
+    loadedChunks[coord].key = key;
+    resources.trackCpu(ResourceCategory::ChunkData, sizeof(Chunk));
+    resources.registerEvictable(ResourceCategory::ChunkData, key, chunkCenter(coord));
+    farTerrainDirty = true;
+  }
+  else
+  {
+    resources.touch(ResourceCategory::ChunkData, loaded->second.key, chunkCenter(coord));
+  }
+
+  octree.updateChunk(client->getWorld(), coord);
+
+  // A resent snapshot goes through the same path, refreshBlock only touches what changed
+  for (int y = 0; y < CHUNK_SIZE; y++)
+  {
+    for (int z = 0; z < CHUNK_SIZE; z++)
+    {
+      for (int x = 0; x < CHUNK_SIZE; x++)
+      {
+        refreshBlock(coord.x * CHUNK_SIZE + x, coord.y * CHUNK_SIZE + y, coord.z * CHUNK_SIZE + z);
+      }
+    }
+  }
+  // Blocks under this chunk may be covered now
+  ChunkCoord below = {coord.x, coord.y - 1, coord.z};
+  refreshTopLayer(below);
+}
+
+void Application::unloadChunk(ChunkCoord coord)
+{
+  std::unordered_map<ChunkCoord, LoadedChunk, ChunkCoordHash>::iterator loaded = loadedChunks.find(coord);
+  if (loaded != loadedChunks.end())
   {
-      // Random x position increment or decrement
-      //const float increment = rand() % 2 == 0 ? -0.1f : 0.1f;
-      //cube.incrementXPosition(increment);
-      //cube.incrementZPosition(increment);
-      //cube.incrementYRotation(increment);
-      //cube.incrementScale(increment);
+    for (std::unordered_map<int, BlockCube>::iterator it = loaded->second.cubes.begin();
+         it != loaded->second.cubes.end(); ++it)
+    {
+      removeCube(it->second.cube);
+    }
+    resources.unregisterEvictable(ResourceCategory::ChunkData, loaded->second.key);
+    resources.releaseCpu(ResourceCategory::ChunkData, sizeof(Chunk));
+    freeChunkKeys.push_back(loaded->second.key);
+    loadedChunks.erase(loaded);
+    // The octree keeps the chunk, it shows up as far terrain instead
+    farTerrainDirty = true;
+  }
+  // Blocks under it are exposed again
+  ChunkCoord below = {coord.x, coord.y - 1, coord.z};
+  refreshTopLayer(below);
+}
+
+// Over the chunk data budget, drop the chunk from the replica until the server sends it again,
+// the octree keeps drawing it as far terrain meanwhile
+void Application::evictChunk(uint32_t key)
+{
+  ChunkCoord coord = chunkKeys[key];
+  client->evictChunk(coord);
+  unloadChunk(coord);
+}
+
+// One cube for a solid block with air above it, none otherwise
+void Application::refreshBlock(int x, int y, int z)
+{
+  ChunkCoord coord = {chunkFloor(x), chunkFloor(y), chunkFloor(z)};
+  std::unordered_map<ChunkCoord, LoadedChunk, ChunkCoordHash>::iterator loaded = loadedChunks.find(coord);
+  if (loaded == loadedChunks.end())
+  {
+    return;
+  }
+  BlockId id = client->getWorld().surfaceBlock(x, y, z);
+  bool visible = id != BLOCK_AIR;
+
+  std::unordered_map<int, BlockCube> &blockCubes = loaded->second.cubes;
+  int index = Chunk::index(chunkLocal(x), chunkLocal(y), chunkLocal(z));
+  std::unordered_map<int, BlockCube>::iterator existing = blockCubes.find(index);
+  if (existing != blockCubes.end())
+  {
+    if (visible && existing->second.id == id)
+    {
+      return;
+    }
+    removeCube(existing->second.cube);
+    blockCubes.erase(existing);
+  }
+  if (visible)
+  {
+    BlockCube blockCube = {addCube(glm::vec3(x, y, z), glm::vec3(1.0f), blockColor(id)), id};
+    blockCubes[index] = blockCube;
+  }
+}
+
+void Application::refreshTopLayer(ChunkCoord coord)
+{
+  if (loadedChunks.find(coord) == loadedChunks.end())
+  {
+    return;
+  }
+  int y = coord.y * CHUNK_SIZE + CHUNK_SIZE - 1;
+  for (int z = 0; z < CHUNK_SIZE; z++)
+  {
+    for (int x = 0; x < CHUNK_SIZE; x++)
+    {
+      refreshBlock(coord.x * CHUNK_SIZE + x, y, coord.z * CHUNK_SIZE + z);
+    }
   }
 }
 
+uint32_t Application::addCube(glm::vec3 position, glm::vec3 scale, glm::vec3 color)
+{
+  uint32_t slot;
+  if (!freeCubes.empty())
+  {
+    slot = freeCubes.back();
+    freeCubes.pop_back();
+  }
+  else
+  {
+    slot = static_cast<uint32_t>(cubes.size());
+    cubes.emplace_back();
+  }
+  cubes[slot].reset(new Cube(slot, transforms, resources, position, glm::vec3(0.0f), scale, color));
+  return slot;
+}
+
+void Application::removeCube(uint32_t slot)
+{
+  cubes[slot].reset();
+  freeCubes.push_back(slot);
+}
+
+// Far terrain is drawn from the octree, diffed against the cubes already placed so only boxes
+// that appeared or disappeared touch GL
+void Application::updateFarTerrain()
+{
+  farTerrainDirty = false;
+  std::vector<VoxelOctree::Box> boxes;
+  octree.collectSolidBoxes(farTerrainLod, boxes);
+
+  std::map<FarBoxKey, uint32_t> kept;
+  for (size_t i = 0; i < boxes.size(); i++)
+  {
+    const VoxelOctree::Box &box = boxes[i];
+    // Centered like block cubes, a box of size n spans blocks x to x + n - 1
+    float half = (box.size - 1) * 0.5f;
+    glm::vec3 center(box.x + half, box.y + half, box.z + half);
+    if (glm::distance(center, cameraPos) > farTerrainDistance || farBoxHidden(box))
+    {
+      continue;
+    }
+    FarBoxKey key(box.x, box.y, box.z, box.size, box.id);
+    std::map<FarBoxKey, uint32_t>::iterator existing = farCubes.find(key);
+    if (existing != farCubes.end())
+    {
+      kept[key] = existing->second;
+      farCubes.erase(existing);
+    }
+    else
+    {
+      kept[key] = addCube(center, glm::vec3(static_cast<float>(box.size)), blockColor(box.id) * 0.6f);
+    }
+  }
+  for (std::map<FarBoxKey, uint32_t>::iterator it = farCubes.begin(); it != farCubes.end(); ++it)
+  {
+    removeCube(it->second);
+  }
+  farCubes.swap(kept);
+}
+
+// Loaded chunks draw their own blocks, and a box whose whole top face is under solid ground can't be seen
+bool Application::farBoxHidden(const VoxelOctree::Box &box) const
+{
+  int above = box.y + box.size;
+  if (octree.isRegionSolid(box.x, above, box.z, box.x + box.size - 1, above, box.z + box.size - 1))
+  {
+    return true;
+  }
+  for (int cy = chunkFloor(box.y); cy <= chunkFloor(box.y + box.size - 1); cy++)
+  {
+    for (int cz = chunkFloor(box.z); cz <= chunkFloor(box.z + box.size - 1); cz++)
+    {
+      for (int cx = chunkFloor(box.x); cx <= chunkFloor(box.x + box.size - 1); cx++)
+      {
+        ChunkCoord coord = {cx, cy, cz};
+        if (loadedChunks.find(coord) != loadedChunks.end())
+        {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+// Block under the crosshair
+void Application::updateLookHit()
+{
+  // Cubes are centered on their block coordinates, the octree's voxels start at them
+  glm::vec3 origin = cameraPos + glm::vec3(0.5f);
+  float rayOrigin[3] = {origin.x, origin.y, origin.z};
+  float rayDirection[3] = {cameraFront.x, cameraFront.y, cameraFront.z};
+  lookHitValid = octree.raycast(rayOrigin, rayDirection, lookDistance, lookHit);
+}
+
+void Application::spawnEntities()
+{
+  player = registry.create();
+  registry.add<Position>(player, Position{cameraPos});
+  registry.add<PlayerTag>(player);
+
+  std::uniform_real_distribution<> spreadX(0.0, terrain5ChunkX - 1);
+  std::uniform_real_distribution<> spreadZ(0.0, terrain5ChunkZ - 1);
+  std::uniform_real_distribution<> bobSpeed(0.5, 2.0);
+
+  for (int i = 0; i < enemyCount; i++)
+  {
+    glm::vec3 start(spreadX(gen), 11.0f, -spreadZ(gen));
+    Entity enemy = registry.create();
+    registry.add<Position>(enemy, Position{start});
+    registry.add<Velocity>(enemy, Velocity{glm::vec3(0.0f)});
+    registry.add<EnemyTag>(enemy, EnemyTag{1.5f});
+    registry.add<CubeRef>(enemy, CubeRef{addCube(start, glm::vec3(0.8f), glm::vec3(dis(gen), 0.1f, 0.1f))});
+  }
+
+  for (int i = 0; i < dynamicPropCount; i++)
+  {
+    glm::vec3 start(spreadX(gen), propMinHeight, -spreadZ(gen));
+    Entity prop = registry.create();
+    registry.add<Position>(prop, Position{start});
+    registry.add<Velocity>(prop, Velocity{glm::vec3(0.0f, bobSpeed(gen), 0.0f)});
+    registry.add<HeightBand>(prop, HeightBand{propMinHeight, propMaxHeight});
+    registry.add<CubeRef>(prop, CubeRef{addCube(start, glm::vec3(0.5f), glm::vec3(0.1f, 0.1f, dis(gen)))});
+  }
+}
+
+// Enemies walk toward the player on the xz plane
+void Application::updateEnemies()
+{
+  if (!registry.valid(player))
+  {
+    return;
+  }
+  glm::vec3 target = registry.get<Position>(player).value;
+  registry.each<EnemyTag>([&](Entity enemy, EnemyTag &tag) {
+    glm::vec3 toPlayer = target - registry.get<Position>(enemy).value;
+    toPlayer.y = 0.0f;
+    float distance = glm::length(toPlayer);
+    registry.get<Velocity>(enemy).value =
+        distance > 1.0f ? toPlayer / distance * tag.speed : glm::vec3(0.0f);
+  });
+}
+
+// Position += Velocity * dt over the packed Position/Velocity group
+// vec3 is three packed floats so each batch is one flat float loop the compiler can vectorize
+void Application::integrateMotion(float dt)
+{
+  registry.parallelForEach<Position, Velocity>([dt](Position *positions, Velocity *velocities, size_t count) {
+    float *p = &positions[0].value.x;
+    const float *v = &velocities[0].value.x;
+    for (size_t i = 0; i < count * 3; i++)
+    {
+      p[i] += v[i] * dt;
+    }
+  });
+}
+
+// Flip vertical velocity when a prop leaves its height band
+// Position and Velocity belong to integrateMotion's group, so look them up instead of grouping them again
+void Application::bounceProps()
+{
+  registry.each<HeightBand>([&](Entity prop, HeightBand &band) {
+    float y = registry.get<Position>(prop).value.y;
+    Velocity &velocity = registry.get<Velocity>(prop);
+    if ((y < band.min && velocity.value.y < 0.0f) || (y > band.max && velocity.value.y > 0.0f))
+    {
+      velocity.value.y = -velocity.value.y;
+    }
+  });
+}
+
+// Push entity positions into the cubes that draw them
+void Application::syncCubes()
+{
+  registry.each<CubeRef>([&](Entity entity, CubeRef &ref) {
+    cubes[ref.index]->setPosition(registry.get<Position>(entity).value);
+  });
+}
+
+void Application::toggleCapture(CaptureFormat format)
+{
+  if (capture.isActive())
+  {
+    capture.stop();
+    std::cout << "Capture stopped, " << capture.getFramesWritten() << " frames written" << std::endl;
+    return;
+  }
+  capture.start(captureDirectory, format);
+  std::cout << "Capturing to " << captureDirectory << std::endl;
+}
+
 void Application::clean()
 {
+  // Finish writing queued frames and free the PBOs while the context is alive
+  capture.stop();
+
   if (ImGui::GetCurrentContext())
   {
     ImGui_ImplOpenGL3_Shutdown();
@@ -409,6 +896,12 @@ void Application::clean()
     glDeleteProgram(shaderProgram);
   }
 
+  // Cube meshes queue their deletes, flush them while the context is still alive
+  loadedChunks.clear();
+  cubes.clear();
+  freeCubes.clear();
+  resources.flushDeletes();
+
   if (glContext)
   {
     SDL_GL_DeleteContext(glContext);
@@ -29,11 +29,30 @@
 
 #include <GL/glew.h>
 
+#include <algorithm>
 #include <cmath>
+#include <map>
+#include <tuple>
 
 // Cube
 #include "Cube.h"
 
+// GPU/CPU memory budgets
+#include "ResourceManager.h"
+
+// Frame capture for golden frame validation and recording
+#include "FrameCapture.h"
+
+// World replication
+#include "Terrain.h"
+#include "WorldClient.h"
+#include "WorldServer.h"
+#include "VoxelOctree.h"
+
+// Entity component system
+#include "ECS.h"
+#include "Components.h"
+
 using namespace glm;
 
 // PreProcessor Declarations
@@ -66,6 +85,8 @@ public:
   void render();
   void clean();
   bool running() { return gameRunning; }
+  // Use a headless world server on localhost instead of the in process one, call before init()
+  void connectTo(int port) { serverPort = port; }
 
   // Getters
   SDL_Window *getWindow() { return window; }
@@ -102,17 +123,96 @@ private:
   int timeDifference;
   float frameAverage;
 
-  // Math functions
-  double easeInOutExpo(double x);
-
-  // Cubes
-  std::vector<Cube> cubes;
+  // Memory accounting, declared before anything that frees through it
+  ResourceManager resources;
+
+  // Transforms for every cube, rebuilt in batches at the end of update()
+  TransformSystem transforms;
+  size_t transformsUpdated;
+
+  // F12 captures PNG frames, F11 records raw frames, both into captureDirectory
+  FrameCapture capture;
+  const char *captureDirectory = "captures";
+  void toggleCapture(CaptureFormat format);
+
+  // Cubes, the slot index is the cube id, empty slots are reused through freeCubes
+  std::vector<std::unique_ptr<Cube>> cubes;
+  std::vector<uint32_t> freeCubes;
+  uint32_t addCube(glm::vec3 position, glm::vec3 scale, glm::vec3 color);
+  void removeCube(uint32_t slot);
+
+  // Entities (player, enemies, dynamic props)
+  Registry registry;
+  Entity player;
+  Uint64 lastUpdateCounter;
+  void spawnEntities();
+  void updateEnemies();
+  void integrateMotion(float dt);
+  void bounceProps();
+  void syncCubes();
+
+  // Memory budgets (bytes)
+  const size_t glBufferBudget = 64 * 1024 * 1024;
+  const size_t chunkDataBudget = 256 * 1024 * 1024;
+
+  // Entity constants
+  const int enemyCount = 16;
+  const int dynamicPropCount = 64;
+  const float propMinHeight = 12.0f;
+  const float propMaxHeight = 20.0f;
 
   // Terrain constants
   const int terrain16ChunkX = 256;
   const int terrain16ChunkZ = 256;
-  const int terrain5ChunkX = 80;
-  const int terrain5ChunkZ = 80;
+  const int terrain5ChunkX = TERRAIN_WIDTH;
+  const int terrain5ChunkZ = TERRAIN_DEPTH;
+
+  // World replication, the server only exists when it runs in process
+  std::unique_ptr<WorldServer> server;
+  std::unique_ptr<WorldClient> client;
+  int serverPort;
+  const int interestRadius = 6;
+  const Uint64 worldSyncTimeoutMs = 5000;
+  void connectWorld();
+  void applyWorldChanges();
+
+  // Cubes for every replicated block with air above it, per chunk
+  // Each chunk is a ChunkData evictable keyed by an id from chunkKeys
+  struct BlockCube {
+    uint32_t cube;
+    BlockId id;
+  };
+  struct LoadedChunk {
+    uint32_t key;
+    std::unordered_map<int, BlockCube> cubes;
+  };
+  std::unordered_map<ChunkCoord, LoadedChunk, ChunkCoordHash> loadedChunks;
+  std::vector<ChunkCoord> chunkKeys;
+  std::vector<uint32_t> freeChunkKeys;
+  void loadChunk(ChunkCoord coord);
+  void unloadChunk(ChunkCoord coord);
+  void evictChunk(uint32_t key);
+  void refreshBlock(int x, int y, int z);
+  void refreshTopLayer(ChunkCoord coord);
+
+  // Octree over the replicated world for coarse queries, updated per chunk as snapshots and deltas arrive
+  // Unloaded chunks stay in it and are drawn as far terrain
+  VoxelOctree octree;
+  VoxelOctree::Hit lookHit;
+  bool lookHitValid;
+  const float lookDistance = 64.0f;
+  void updateLookHit();
+
+  // Coarse cubes for octree boxes outside the loaded chunks, keyed by box origin, size and block
+  typedef std::tuple<int, int, int, int, int> FarBoxKey;
+  std::map<FarBoxKey, uint32_t> farCubes;
+  bool farTerrainDirty;
+  const int farTerrainLod = 8;
+  const float farTerrainDistance = 256.0f;
+  // Clip distance, past the farthest box center by enough to keep boxes up to two chunks wide whole
+  const float farPlane = farTerrainDistance + 2.0f * CHUNK_SIZE;
+  void updateFarTerrain();
+  bool farBoxHidden(const VoxelOctree::Box &box) const;
 
   // Helper function for shader creation
   GLuint createShader(GLenum type, const char *source);
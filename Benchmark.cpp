@@ -0,0 +1,482 @@
+// Microbenchmarks for the CPU hot paths, no window or GL context needed
+// Jacob Lowe
+//
+// make bench                                  build engine_bench
+// ./engine_bench                              print ns/op, throughput and allocations
+// ./engine_bench --save bench_baseline.json   record a baseline
+// ./engine_bench --compare bench_baseline.json [--threshold 0.15]
+//     exit 1 if any benchmark got slower than baseline by more than threshold,
+//     or by more than twice its own run to run noise when that's larger
+// ./engine_bench --rounds 5                   passes over the whole suite, the fastest batch of any pass counts
+
+#include "Chunk.h"
+#include "Terrain.h"
+#include "TransformSystem.h"
+#include "VoxelOctree.h"
+#include "World.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// Count every heap allocation made while a benchmark runs
+static std::atomic<size_t> allocationCount(0);
+
+void *operator new(size_t size)
+{
+  allocationCount++;
+  void *p = std::malloc(size ? size : 1);
+  if (!p)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  std::free(p);
+}
+
+// Stops the optimizer from throwing away benchmark results
+static volatile float floatSink;
+static volatile int intSink;
+
+// Timed batches per benchmark in each pass over the suite
+// The fastest is what gets compared since noise only ever adds time
+static const int BENCH_REPETITIONS = 5;
+
+struct BenchResult
+{
+  std::string name;
+  double itemsPerOp;
+  // ns/op of the fastest batch in each pass over the suite
+  std::vector<double> passBest;
+  // Fastest batch of any pass, and the median of the per pass fastest
+  double nsPerOp;
+  double medianNsPerOp;
+  double itemsPerSecond;
+  double allocationsPerOp;
+};
+
+static void summarize(BenchResult &result)
+{
+  std::vector<double> sorted = result.passBest;
+  std::sort(sorted.begin(), sorted.end());
+  result.nsPerOp = sorted.front();
+  result.medianNsPerOp = sorted[sorted.size() / 2];
+  result.itemsPerSecond = result.itemsPerOp * 1e9 / result.nsPerOp;
+}
+
+// Pass to pass noise, how far the typical pass is above the fastest one
+static double benchNoise(double nsPerOp, double medianNsPerOp)
+{
+  return nsPerOp > 0.0 ? medianNsPerOp / nsPerOp - 1.0 : 0.0;
+}
+
+template <typename Fn>
+static double timeBatch(Fn &fn, size_t iterations)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++)
+  {
+    fn();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Grow a batch of fn() calls until it runs for at least minSeconds, then time BENCH_REPETITIONS batches of that size
+// itemsPerOp is how many units of work (columns, matrices, blocks) one call does
+template <typename Fn>
+BenchResult runBench(const std::string &name, double itemsPerOp, Fn fn, double minSeconds = 0.02)
+{
+  // Warm up caches and any lazy allocations
+  fn();
+
+  size_t iterations = 1;
+  while (timeBatch(fn, iterations) < minSeconds && iterations < (size_t(1) << 30))
+  {
+    iterations *= 2;
+  }
+
+  BenchResult result;
+  result.name = name;
+  result.itemsPerOp = itemsPerOp;
+  double best = 0.0;
+  size_t allocationsBefore = allocationCount;
+  for (int r = 0; r < BENCH_REPETITIONS; r++)
+  {
+    double nsPerOp = timeBatch(fn, iterations) * 1e9 / iterations;
+    best = r == 0 ? nsPerOp : std::min(best, nsPerOp);
+  }
+  size_t allocations = allocationCount - allocationsBefore;
+  result.passBest.push_back(best);
+  result.allocationsPerOp = static_cast<double>(allocations) / (iterations * BENCH_REPETITIONS);
+  summarize(result);
+  return result;
+}
+
+// Cube::getModelMatrix before the transform system, kept as the reference
+static glm::mat4 eulerModelMatrix(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale)
+{
+  glm::mat4 model = glm::mat4(1.0f);
+  model = glm::translate(model, position);
+  model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+  model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+  model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+  model = glm::scale(model, scale);
+  return model;
+}
+
+static std::vector<BenchResult> runAll()
+{
+  std::vector<BenchResult> results;
+  std::mt19937 gen(1234);
+  const int columns = TERRAIN_WIDTH * TERRAIN_DEPTH;
+
+  // Terrain
+  results.push_back(runBench("terrain/easeInOutExpo", TERRAIN_DEPTH, [&]() {
+    double total = 0.0;
+    for (int z = 0; z < TERRAIN_DEPTH; z++)
+    {
+      total += Terrain::easeInOutExpo(static_cast<double>(z) / (TERRAIN_DEPTH - 1));
+    }
+    floatSink = static_cast<float>(total);
+  }));
+
+  results.push_back(runBench("terrain/generate", columns, [&]() {
+    World world;
+    Terrain::generate(world, TERRAIN_WIDTH, TERRAIN_DEPTH, TERRAIN_MAX_HEIGHT);
+    intSink = static_cast<int>(world.chunkCount());
+  }));
+
+  World world;
+  Terrain::generate(world, TERRAIN_WIDTH, TERRAIN_DEPTH, TERRAIN_MAX_HEIGHT);
+
+  // Surface extraction, every block of every chunk tested the way Application::loadChunk does on a snapshot
+  std::vector<ChunkCoord> chunkCoords;
+  for (World::ChunkMap::const_iterator it = world.getChunks().begin(); it != world.getChunks().end(); ++it)
+  {
+    chunkCoords.push_back(it->first);
+  }
+  results.push_back(runBench("mesh/chunk_surface", static_cast<double>(chunkCoords.size()) * CHUNK_VOLUME, [&]() {
+    int visible = 0;
+    for (size_t i = 0; i < chunkCoords.size(); i++)
+    {
+      const ChunkCoord &c = chunkCoords[i];
+      for (int y = 0; y < CHUNK_SIZE; y++)
+      {
+        for (int z = 0; z < CHUNK_SIZE; z++)
+        {
+          for (int x = 0; x < CHUNK_SIZE; x++)
+          {
+            visible += world.surfaceBlock(c.x * CHUNK_SIZE + x, c.y * CHUNK_SIZE + y, c.z * CHUNK_SIZE + z) !=
+                       BLOCK_AIR;
+          }
+        }
+      }
+    }
+    intSink = visible;
+  }));
+
+  // Model matrices
+  const int matrixCount = 4096;
+  std::uniform_real_distribution<float> coord(-100.0f, 100.0f);
+  std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+  std::vector<glm::vec3> positions, rotations;
+  TransformSystem transforms;
+  for (int i = 0; i < matrixCount; i++)
+  {
+    positions.push_back(glm::vec3(coord(gen), coord(gen), coord(gen)));
+    rotations.push_back(glm::vec3(angle(gen), angle(gen), angle(gen)));
+    transforms.create(positions.back(), rotations.back(), glm::vec3(1.0f));
+  }
+  transforms.update();
+
+  results.push_back(runBench("transform/euler_reference", matrixCount, [&]() {
+    float total = 0.0f;
+    for (int i = 0; i < matrixCount; i++)
+    {
+      total += eulerModelMatrix(positions[i], rotations[i], glm::vec3(1.0f))[3][0];
+    }
+    floatSink = total;
+  }));
+
+  float nudge = 0.0f;
+  results.push_back(runBench("transform/batched_all_dirty", matrixCount, [&]() {
+    nudge = nudge == 0.0f ? 1.0f : 0.0f;
+    for (int i = 0; i < matrixCount; i++)
+    {
+      transforms.setPosition(i, positions[i] + glm::vec3(nudge));
+    }
+    intSink = static_cast<int>(transforms.update());
+  }));
+
+  results.push_back(runBench("transform/batched_static", matrixCount, [&]() {
+    intSink = static_cast<int>(transforms.update());
+  }));
+
+  // Chunk storage
+  const int accessCount = 4096;
+  std::uniform_int_distribution<int> blockX(0, TERRAIN_WIDTH - 1);
+  std::uniform_int_distribution<int> blockY(0, static_cast<int>(TERRAIN_MAX_HEIGHT));
+  std::uniform_int_distribution<int> blockZ(-(TERRAIN_DEPTH - 1), 0);
+  std::vector<int> accesses;
+  for (int i = 0; i < accessCount; i++)
+  {
+    accesses.push_back(blockX(gen));
+    accesses.push_back(blockY(gen));
+    accesses.push_back(blockZ(gen));
+  }
+
+  results.push_back(runBench("chunk/get", accessCount, [&]() {
+    int total = 0;
+    for (int i = 0; i < accessCount; i++)
+    {
+      total += world.getBlock(accesses[i * 3], accesses[i * 3 + 1], accesses[i * 3 + 2]);
+    }
+    intSink = total;
+  }));
+
+  // Writes go to a world of their own so everything after this measures unmodified terrain
+  World editedWorld;
+  Terrain::generate(editedWorld, TERRAIN_WIDTH, TERRAIN_DEPTH, TERRAIN_MAX_HEIGHT);
+  BlockId toggle = BLOCK_GROUND;
+  results.push_back(runBench("chunk/set", accessCount, [&]() {
+    toggle = toggle == BLOCK_GROUND ? BLOCK_PLACED : BLOCK_GROUND;
+    for (int i = 0; i < accessCount; i++)
+    {
+      editedWorld.setBlock(accesses[i * 3], accesses[i * 3 + 1], accesses[i * 3 + 2], toggle);
+    }
+  }));
+
+  ChunkCoord origin = {0, 0, 0};
+  const Chunk &chunk = *world.getChunk(origin);
+  std::vector<uint8_t> compressed;
+  results.push_back(runBench("chunk/compress", CHUNK_VOLUME, [&]() {
+    compressed.clear();
+    chunk.compress(compressed);
+    intSink = static_cast<int>(compressed.size());
+  }));
+
+  Chunk decoded;
+  results.push_back(runBench("chunk/decompress", CHUNK_VOLUME, [&]() {
+    intSink = decoded.decompress(compressed.data(), compressed.size());
+  }));
+
+  // Octree queries over the same terrain
+  VoxelOctree octree;
+  results.push_back(runBench("octree/build", columns, [&]() {
+    octree.build(world);
+    intSink = static_cast<int>(octree.nodeCount());
+  }));
+
+  // What a snapshot or delta costs, one chunk's path rebuilt instead of the whole tree
+  ChunkCoord middle = {chunkFloor(TERRAIN_WIDTH / 2), 0, chunkFloor(-TERRAIN_DEPTH / 2)};
+  results.push_back(runBench("octree/update_chunk", 1, [&]() {
+    octree.updateChunk(world, middle);
+    intSink = static_cast<int>(octree.nodeCount());
+  }));
+
+  results.push_back(runBench("octree/get", accessCount, [&]() {
+    int total = 0;
+    for (int i = 0; i < accessCount; i++)
+    {
+      total += octree.get(accesses[i * 3], accesses[i * 3 + 1], accesses[i * 3 + 2]);
+    }
+    intSink = total;
+  }));
+
+  results.push_back(runBench("octree/highest_solid", columns, [&]() {
+    int total = 0;
+    for (int x = 0; x < TERRAIN_WIDTH; x++)
+    {
+      for (int z = 0; z < TERRAIN_DEPTH; z++)
+      {
+        int y;
+        if (octree.highestSolid(x, -z, y))
+        {
+          total += y;
+        }
+      }
+    }
+    intSink = total;
+  }));
+
+  const int rayCount = 256;
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  std::vector<float> rays;
+  for (int i = 0; i < rayCount; i++)
+  {
+    rays.push_back(TERRAIN_WIDTH / 2.0f);
+    rays.push_back(20.0f);
+    rays.push_back(-TERRAIN_DEPTH / 2.0f);
+    rays.push_back(unit(gen));
+    rays.push_back(-1.0f);
+    rays.push_back(unit(gen));
+  }
+  results.push_back(runBench("octree/raycast", rayCount, [&]() {
+    int hits = 0;
+    VoxelOctree::Hit hit;
+    for (int i = 0; i < rayCount; i++)
+    {
+      hits += octree.raycast(&rays[i * 6], &rays[i * 6 + 3], 128.0f, hit);
+    }
+    intSink = hits;
+  }));
+
+  return results;
+}
+
+static void printResults(const std::vector<BenchResult> &results)
+{
+  std::printf("%-30s %14s %14s %16s %12s\n", "benchmark", "ns/op", "median pass", "items/s", "allocs/op");
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    const BenchResult &r = results[i];
+    std::printf("%-30s %14.1f %14.1f %16.3e %12.2f\n", r.name.c_str(), r.nsPerOp, r.medianNsPerOp, r.itemsPerSecond,
+                r.allocationsPerOp);
+  }
+}
+
+static bool saveBaseline(const std::vector<BenchResult> &results, const std::string &path)
+{
+  Json::Value root(Json::objectValue);
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    Json::Value entry(Json::objectValue);
+    entry["ns_per_op"] = results[i].nsPerOp;
+    entry["median_ns_per_op"] = results[i].medianNsPerOp;
+    entry["items_per_second"] = results[i].itemsPerSecond;
+    entry["allocations_per_op"] = results[i].allocationsPerOp;
+    root[results[i].name] = entry;
+  }
+  std::ofstream file(path.c_str());
+  if (!file)
+  {
+    std::cerr << "Could not write " << path << std::endl;
+    return false;
+  }
+  file << root;
+  std::cout << "Baseline saved to " << path << std::endl;
+  return true;
+}
+
+// Returns the number of regressions, -1 if the baseline can't be read
+static int compareBaseline(const std::vector<BenchResult> &results, const std::string &path, double threshold)
+{
+  std::ifstream file(path.c_str());
+  Json::Value root;
+  Json::CharReaderBuilder builder;
+  std::string errors;
+  if (!file || !Json::parseFromStream(builder, file, &root, &errors))
+  {
+    std::cerr << "Could not read baseline " << path << " " << errors << std::endl;
+    return -1;
+  }
+
+  int regressions = 0;
+  std::printf("\n%-30s %14s %14s %9s %9s\n", "benchmark", "baseline ns", "current ns", "change", "allowed");
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    const BenchResult &r = results[i];
+    if (!root.isMember(r.name))
+    {
+      std::printf("%-30s %14s %14.1f %9s\n", r.name.c_str(), "-", r.nsPerOp, "new");
+      continue;
+    }
+    const Json::Value &entry = root[r.name];
+    double baseline = entry["ns_per_op"].asDouble();
+    double change = baseline > 0.0 ? r.nsPerOp / baseline - 1.0 : 0.0;
+    // Benchmarks that jitter more than the threshold between batches get a wider margin
+    double noise = std::max(benchNoise(baseline, entry.get("median_ns_per_op", baseline).asDouble()),
+                            benchNoise(r.nsPerOp, r.medianNsPerOp));
+    double allowed = std::max(threshold, 2.0 * noise);
+    // A hot path that starts allocating is a regression no matter the timing
+    bool newAllocations = entry["allocations_per_op"].asDouble() == 0.0 && r.allocationsPerOp > 0.0;
+    bool regressed = change > allowed || newAllocations;
+    std::printf("%-30s %14.1f %14.1f %+8.1f%% %8.1f%%%s\n", r.name.c_str(), baseline, r.nsPerOp, change * 100.0,
+                allowed * 100.0, regressed ? "  REGRESSION" : "");
+    if (regressed)
+    {
+      regressions++;
+    }
+  }
+  return regressions;
+}
+
+int main(int argc, char *args[])
+{
+  std::string savePath;
+  std::string comparePath;
+  double threshold = 0.15;
+  // Slow spells on a busy machine outlast one benchmark, separate passes rarely all land in one
+  int rounds = 5;
+  for (int i = 1; i + 1 < argc; i++)
+  {
+    std::string arg = args[i];
+    if (arg == "--save")
+    {
+      savePath = args[++i];
+    }
+    else if (arg == "--compare")
+    {
+      comparePath = args[++i];
+    }
+    else if (arg == "--threshold")
+    {
+      threshold = std::atof(args[++i]);
+    }
+    else if (arg == "--rounds")
+    {
+      rounds = std::max(1, std::atoi(args[++i]));
+    }
+  }
+
+  std::vector<BenchResult> results = runAll();
+  for (int round = 1; round < rounds; round++)
+  {
+    std::vector<BenchResult> more = runAll();
+    for (size_t i = 0; i < results.size(); i++)
+    {
+      results[i].passBest.push_back(more[i].passBest.front());
+      // Growth that only happens once, like a vector reaching its final size, shows up in the first pass only
+      results[i].allocationsPerOp = std::min(results[i].allocationsPerOp, more[i].allocationsPerOp);
+      summarize(results[i]);
+    }
+  }
+  printResults(results);
+
+  if (!savePath.empty() && !saveBaseline(results, savePath))
+  {
+    return 1;
+  }
+  if (!comparePath.empty())
+  {
+    int regressions = compareBaseline(results, comparePath, threshold);
+    if (regressions != 0)
+    {
+      std::cerr << (regressions < 0 ? "Baseline comparison failed" : "Hot path regression detected") << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
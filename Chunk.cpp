@@ -0,0 +1,54 @@
+#include "Chunk.h"
+#include "Protocol.h"
+#include <cstring>
+
+Chunk::Chunk() : solidCount(0) {
+    std::memset(blocks, BLOCK_AIR, sizeof(blocks));
+}
+
+void Chunk::setIndex(int i, BlockId id) {
+    BlockId old = blocks[i];
+    if (old == id) {
+        return;
+    }
+    if (old == BLOCK_AIR) {
+        solidCount++;
+    } else if (id == BLOCK_AIR) {
+        solidCount--;
+    }
+    blocks[i] = id;
+}
+
+void Chunk::compress(std::vector<uint8_t> &out) const {
+    ByteWriter writer(out);
+    int i = 0;
+    while (i < CHUNK_VOLUME) {
+        BlockId id = blocks[i];
+        int run = 1;
+        while (i + run < CHUNK_VOLUME && blocks[i + run] == id) {
+            run++;
+        }
+        writer.varint(static_cast<uint32_t>(run));
+        writer.u8(id);
+        i += run;
+    }
+}
+
+bool Chunk::decompress(const uint8_t *data, size_t size) {
+    ByteReader reader(data, size);
+    int i = 0;
+    solidCount = 0;
+    while (i < CHUNK_VOLUME && reader.ok() && reader.remaining() > 0) {
+        uint32_t run = reader.varint();
+        BlockId id = reader.u8();
+        if (!reader.ok() || run == 0 || run > static_cast<uint32_t>(CHUNK_VOLUME - i)) {
+            return false;
+        }
+        std::memset(blocks + i, id, run);
+        if (id != BLOCK_AIR) {
+            solidCount += static_cast<int>(run);
+        }
+        i += static_cast<int>(run);
+    }
+    return i == CHUNK_VOLUME;
+}
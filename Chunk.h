@@ -0,0 +1,63 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+typedef uint8_t BlockId;
+const BlockId BLOCK_AIR = 0;
+const BlockId BLOCK_GROUND = 1;
+const BlockId BLOCK_SURFACE = 2;
+const BlockId BLOCK_PLACED = 3;
+
+const int CHUNK_SIZE = 16;
+const int CHUNK_VOLUME = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+
+struct ChunkCoord {
+    int x, y, z;
+};
+
+inline bool operator==(const ChunkCoord &a, const ChunkCoord &b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+inline bool operator!=(const ChunkCoord &a, const ChunkCoord &b) { return !(a == b); }
+
+struct ChunkCoordHash {
+    size_t operator()(const ChunkCoord &c) const {
+        return static_cast<size_t>(c.x) * 73856093u ^ static_cast<size_t>(c.y) * 19349663u ^
+               static_cast<size_t>(c.z) * 83492791u;
+    }
+};
+
+// Floor division so negative world coordinates land in the right chunk
+inline int chunkFloor(int v) { return v >= 0 ? v / CHUNK_SIZE : (v - CHUNK_SIZE + 1) / CHUNK_SIZE; }
+inline int chunkLocal(int v) { return v - chunkFloor(v) * CHUNK_SIZE; }
+
+// 16^3 block ids, stored y major so horizontal layers are contiguous
+class Chunk {
+private:
+    BlockId blocks[CHUNK_VOLUME];
+    int solidCount;
+
+public:
+    Chunk();
+
+    static int index(int x, int y, int z) { return x + z * CHUNK_SIZE + y * CHUNK_SIZE * CHUNK_SIZE; }
+
+    BlockId get(int x, int y, int z) const { return blocks[index(x, y, z)]; }
+    BlockId getIndex(int i) const { return blocks[i]; }
+    void set(int x, int y, int z, BlockId id) { setIndex(index(x, y, z), id); }
+    void setIndex(int i, BlockId id);
+
+    bool isEmpty() const { return solidCount == 0; }
+    int getSolidCount() const { return solidCount; }
+    const BlockId *data() const { return blocks; }
+
+    // Run length encoding as (varint run, block) pairs
+    // Flat terrain layers collapse to a handful of runs
+    void compress(std::vector<uint8_t> &out) const;
+    bool decompress(const uint8_t *data, size_t size);
+};
+
+#endif // CHUNK_H
@@ -0,0 +1,39 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// Plain data components stored in the ECS registry
+// Kept as tightly packed floats so the systems can treat the dense arrays as float streams
+
+struct Position {
+    glm::vec3 value;
+};
+
+struct Velocity {
+    glm::vec3 value;
+};
+
+// Keeps an entity bouncing vertically between two heights
+struct HeightBand {
+    float min;
+    float max;
+};
+
+// Links an entity to a Cube in Application::cubes for drawing
+struct CubeRef {
+    size_t index;
+};
+
+// Tags
+struct PlayerTag {};
+struct EnemyTag {
+    float speed;
+};
+
+// Motion systems walk Position/Velocity arrays as flat float streams
+static_assert(sizeof(Position) == 3 * sizeof(float), "Position must be tightly packed");
+static_assert(sizeof(Velocity) == 3 * sizeof(float), "Velocity must be tightly packed");
+
+#endif // COMPONENTS_H
@@ -1,10 +1,12 @@
 #include "Cube.h"
 #include <iostream>
 
-Cube::Cube(unsigned int id, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale,
-    glm::vec3 color)
-    : id(id), position(position), rotation(rotation), scale(scale),
-    VAO(0), VBO(0), EBO(0), color(color) {
+const size_t Cube::MESH_BYTES = 8 * sizeof(Cube::Vertex) + 36 * sizeof(unsigned int);
+
+Cube::Cube(unsigned int id, TransformSystem &transforms, ResourceManager &resources,
+    glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, glm::vec3 color)
+    : id(id), transforms(&transforms), transform(transforms.create(position, rotation, scale)),
+    resources(&resources), VAO(0), VBO(0), EBO(0), color(color) {
     // Generate a random color
 
     // std::cout << "Cube " << id << " constructed at " << this
@@ -14,17 +16,23 @@ Cube::Cube(unsigned int id, glm::vec3 position, glm::vec3 rotation, glm::vec3 sc
 
 Cube::~Cube() {
     //std::cout << "Cube " << id << " destroyed at " << this << std::endl;
+    // Moved from cubes have no mesh, the id now belongs to the new owner
     if (VAO != 0) {
-        glDeleteVertexArrays(1, &VAO);
-    }
-    if (VBO != 0) {
-        glDeleteBuffers(1, &VBO);
+        releaseMesh();
     }
-    if (EBO != 0) {
-        glDeleteBuffers(1, &EBO);
+    if (transforms) {
+        transforms->destroy(transform);
     }
 }
 
+void Cube::releaseMesh() {
+    resources->unregisterEvictable(ResourceCategory::GLBuffers, id);
+    resources->releaseVertexArray(VAO);
+    resources->releaseBuffer(VBO);
+    resources->releaseBuffer(EBO);
+    VAO = VBO = EBO = 0;
+}
+
 void Cube::setupMesh() {
     struct Vertex {
         glm::vec3 position_cords;
@@ -51,7 +59,6 @@ void Cube::setupMesh() {
     };
 
     glGenVertexArrays(1, &VAO);
-    std::cout << "Generated VAO: " << VAO << std::endl;
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
 
@@ -73,19 +80,24 @@ void Cube::setupMesh() {
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+
+    resources->trackBuffer(VBO, sizeof(vertices));
+    resources->trackBuffer(EBO, sizeof(indices));
+    resources->registerEvictable(ResourceCategory::GLBuffers, id, getPosition());
 }
 
 // Move constructor
 Cube::Cube(Cube&& other) noexcept
     : id(other.id),
-      position(std::move(other.position)),
-      rotation(std::move(other.rotation)),
-      scale(std::move(other.scale)),
+      transforms(other.transforms),
+      transform(other.transform),
+      resources(other.resources),
       color(std::move(other.color)),  // Add this line
       VAO(other.VAO),
       VBO(other.VBO),
       EBO(other.EBO) {
     other.VAO = other.VBO = other.EBO = 0;
+    other.transforms = nullptr;
     // std::cout << "Cube " << id << " move constructed at " << this
     //           << " with VAO: " << VAO
     //           << " and color: " << color.r << ", " << color.g << ", " << color.b << std::endl;
@@ -93,6 +105,15 @@ Cube::Cube(Cube&& other) noexcept
 
 
 void Cube::draw() {
+    if (VAO == 0) {
+        // Evicted, only rebuild if the budget has room for it
+        if (!resources->reserve(ResourceCategory::GLBuffers, MESH_BYTES, getPosition())) {
+            return;
+        }
+        setupMesh();
+    }
+    resources->touch(ResourceCategory::GLBuffers, id, getPosition());
+
     glBindVertexArray(VAO);
     // Check if the VBO and EBO are still bound to the VAO
     GLint vbo_bound, ebo_bound;
@@ -110,12 +131,7 @@ void Cube::draw() {
 
 }
 
-glm::mat4 Cube::getModelMatrix() const {
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, position);
-    model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-    model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-    model = glm::scale(model, scale);
-    return model;
+// Cached by the transform system, rebuilt only when this cube moves
+const glm::mat4 &Cube::getModelMatrix() const {
+    return transforms->getWorldMatrix(transform);
 }
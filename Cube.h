@@ -6,15 +6,19 @@
 #include <GL/glew.h>
 #include <iostream>
 #include <random>
+#include "TransformSystem.h"
+#include "ResourceManager.h"
 
 class Cube {
 private:
     unsigned int id;
     glm::vec3 color;
     unsigned int VAO, VBO, EBO;
-    glm::vec3 position;
-    glm::vec3 rotation;
-    glm::vec3 scale;
+    // Position, rotation and scale live in the shared transform system
+    TransformSystem *transforms;
+    TransformHandle transform;
+    // Accounts and defers deletion of the mesh buffers
+    ResourceManager *resources;
 
     struct Vertex {
         glm::vec3 position_cords;
@@ -23,19 +27,25 @@ private:
     void setupMesh();
 
 public:
+    // GPU bytes held by one cube mesh (vertex + index buffer)
+    static const size_t MESH_BYTES;
+
     Cube(
         unsigned int id,
+        TransformSystem &transforms,
+        ResourceManager &resources,
         glm::vec3 position,
         glm::vec3 rotation,
         glm::vec3 scale,
         glm::vec3 color
     );
 
-    void incrementXPosition(float increment) { position.x += increment; }
-    void incrementYPosition(float increment) { position.y += increment; }
-    void incrementZPosition(float increment) { position.z += increment; }
-    void incrementScale(float increment) { scale += glm::vec3(increment); }
-    void incrementYRotation(float increment) { rotation.y += increment; }
+    void incrementXPosition(float increment) { transforms->translate(transform, glm::vec3(increment, 0.0f, 0.0f)); }
+    void incrementYPosition(float increment) { transforms->translate(transform, glm::vec3(0.0f, increment, 0.0f)); }
+    void incrementZPosition(float increment) { transforms->translate(transform, glm::vec3(0.0f, 0.0f, increment)); }
+    void incrementScale(float increment) { transforms->addScale(transform, glm::vec3(increment)); }
+    void incrementYRotation(float increment) { transforms->rotate(transform, glm::vec3(0.0f, increment, 0.0f)); }
+    void setPosition(glm::vec3 newPosition) { transforms->setPosition(transform, newPosition); }
     // Move constructor
     Cube(Cube&& other) noexcept;
 
@@ -50,8 +60,14 @@ public:
     unsigned int getEBO() const { return EBO; }
     unsigned int getId() const { return id; }
 
+    // Hand the mesh buffers back to the resource manager, draw() rebuilds it when there's room
+    void releaseMesh();
+    bool hasMesh() const { return VAO != 0; }
+
     void draw();
-    glm::mat4 getModelMatrix() const;
+    glm::vec3 getPosition() const { return transforms->getPosition(transform); }
+    glm::vec3 getScale() const { return transforms->getScale(transform); }
+    const glm::mat4 &getModelMatrix() const;
 };
 
 #endif // CUBE_H
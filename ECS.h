@@ -0,0 +1,371 @@
+#ifndef ECS_H
+#define ECS_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Entity handle, just an index into the registry
+typedef uint32_t Entity;
+const Entity NULL_ENTITY = 0xFFFFFFFF;
+
+// Persistent worker threads for parallelFor, started once instead of per call
+// run() hands out indices [0, count) to the workers and the calling thread, and returns when all are done
+class WorkerPool {
+private:
+    std::vector<std::thread> threads;
+    std::mutex runMutex;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    // Current job, only touched under mutex except for the atomic counters
+    const std::function<void(size_t)> *job;
+    size_t jobCount;
+    std::atomic<size_t> nextIndex;
+    std::atomic<size_t> remaining;
+    // Workers still inside the current job, run() waits for them so none outlive it
+    size_t busy;
+    uint64_t generation;
+    bool stopping;
+
+    void drain(const std::function<void(size_t)> &fn, size_t count) {
+        while (true) {
+            size_t i = nextIndex.fetch_add(1);
+            if (i >= count) {
+                return;
+            }
+            fn(i);
+            remaining.fetch_sub(1);
+        }
+    }
+
+    void workerLoop() {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            if (!job) {
+                continue;
+            }
+            const std::function<void(size_t)> *fn = job;
+            size_t count = jobCount;
+            busy++;
+            lock.unlock();
+            drain(*fn, count);
+            lock.lock();
+            busy--;
+            done.notify_all();
+        }
+    }
+
+public:
+    explicit WorkerPool(size_t workers)
+        : job(nullptr), jobCount(0), nextIndex(0), remaining(0), busy(0), generation(0), stopping(false) {
+        for (size_t i = 0; i < workers; i++) {
+            threads.emplace_back(&WorkerPool::workerLoop, this);
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Workers plus the calling thread
+    size_t concurrency() const { return threads.size() + 1; }
+
+    void run(size_t count, const std::function<void(size_t)> &fn) {
+        std::lock_guard<std::mutex> runLock(runMutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            jobCount = count;
+            nextIndex = 0;
+            remaining = count;
+            generation++;
+        }
+        wake.notify_all();
+        drain(fn, count);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]() { return remaining == 0 && busy == 0; });
+        job = nullptr;
+    }
+
+    // One pool for the whole process, sized to the hardware
+    static WorkerPool &shared() {
+        static WorkerPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+        return pool;
+    }
+};
+
+// Split [0, count) into batches and run them on the shared worker pool
+// fn(begin, end) is called once per batch, the caller thread takes part
+template <typename Fn>
+void parallelFor(size_t count, Fn fn, size_t minBatch = 4096) {
+    if (count == 0) {
+        return;
+    }
+    WorkerPool &pool = WorkerPool::shared();
+    size_t batches = std::min(pool.concurrency(), (count + minBatch - 1) / minBatch);
+    if (batches <= 1) {
+        fn(size_t(0), count);
+        return;
+    }
+    size_t batchSize = (count + batches - 1) / batches;
+    std::function<void(size_t)> batch = [&](size_t b) {
+        size_t begin = b * batchSize;
+        if (begin < count) {
+            fn(begin, std::min(begin + batchSize, count));
+        }
+    };
+    pool.run(batches, batch);
+}
+
+// Type erased pool so the registry can hold every component type together
+class BasePool {
+public:
+    virtual ~BasePool() {}
+    virtual bool has(Entity entity) const = 0;
+    virtual void remove(Entity entity) = 0;
+};
+
+// Sparse set storage for one component type
+// Components live in a dense array (one array per type, so SoA across components)
+// sparse maps entity -> dense slot, entities maps dense slot -> entity
+template <typename T>
+class ComponentPool : public BasePool {
+private:
+    std::vector<uint32_t> sparse;
+    std::vector<Entity> entities;
+    std::vector<T> components;
+    // Bumped whenever dense order changes, used to know when groups need repacking
+    uint64_t version;
+
+public:
+    ComponentPool() : version(0) {}
+
+    bool has(Entity entity) const {
+        return entity < sparse.size() && sparse[entity] != NULL_ENTITY;
+    }
+
+    T &add(Entity entity, const T &component) {
+        if (has(entity)) {
+            return components[sparse[entity]] = component;
+        }
+        if (entity >= sparse.size()) {
+            sparse.resize(entity + 1, NULL_ENTITY);
+        }
+        sparse[entity] = static_cast<uint32_t>(entities.size());
+        entities.push_back(entity);
+        components.push_back(component);
+        version++;
+        return components.back();
+    }
+
+    // Swap with the last slot so the dense arrays stay packed
+    void remove(Entity entity) {
+        if (!has(entity)) {
+            return;
+        }
+        uint32_t slot = sparse[entity];
+        uint32_t last = static_cast<uint32_t>(entities.size() - 1);
+        if (slot != last) {
+            entities[slot] = entities[last];
+            components[slot] = std::move(components[last]);
+            sparse[entities[slot]] = slot;
+        }
+        entities.pop_back();
+        components.pop_back();
+        sparse[entity] = NULL_ENTITY;
+        version++;
+    }
+
+    void swapSlots(uint32_t a, uint32_t b) {
+        if (a == b) {
+            return;
+        }
+        std::swap(entities[a], entities[b]);
+        std::swap(components[a], components[b]);
+        sparse[entities[a]] = a;
+        sparse[entities[b]] = b;
+        version++;
+    }
+
+    T &get(Entity entity) { return components[sparse[entity]]; }
+    const T &get(Entity entity) const { return components[sparse[entity]]; }
+    uint32_t slotOf(Entity entity) const { return sparse[entity]; }
+
+    size_t size() const { return entities.size(); }
+    uint64_t getVersion() const { return version; }
+    T *data() { return components.data(); }
+    const Entity *entityData() const { return entities.data(); }
+};
+
+// Owns entities and their component pools
+class Registry {
+private:
+    std::vector<std::unique_ptr<BasePool>> pools;
+    std::vector<bool> alive;
+    std::vector<Entity> freeList;
+
+    // Cached group sizes keyed by the pool pair, valid while both pool versions match
+    struct GroupCache {
+        uint64_t versionA;
+        uint64_t versionB;
+        size_t size;
+    };
+    std::map<std::pair<size_t, size_t>, GroupCache> groups;
+
+    static size_t nextComponentId() {
+        static size_t counter = 0;
+        return counter++;
+    }
+
+    template <typename T>
+    static size_t componentId() {
+        static size_t id = nextComponentId();
+        return id;
+    }
+
+public:
+    template <typename T>
+    ComponentPool<T> &pool() {
+        size_t id = componentId<T>();
+        if (id >= pools.size()) {
+            pools.resize(id + 1);
+        }
+        if (!pools[id]) {
+            pools[id].reset(new ComponentPool<T>());
+        }
+        return *static_cast<ComponentPool<T> *>(pools[id].get());
+    }
+
+    Entity create() {
+        if (!freeList.empty()) {
+            Entity entity = freeList.back();
+            freeList.pop_back();
+            alive[entity] = true;
+            return entity;
+        }
+        alive.push_back(true);
+        return static_cast<Entity>(alive.size() - 1);
+    }
+
+    void destroy(Entity entity) {
+        if (!valid(entity)) {
+            return;
+        }
+        for (auto &p : pools) {
+            if (p) {
+                p->remove(entity);
+            }
+        }
+        alive[entity] = false;
+        freeList.push_back(entity);
+    }
+
+    bool valid(Entity entity) const { return entity < alive.size() && alive[entity]; }
+    size_t aliveCount() const { return alive.size() - freeList.size(); }
+
+    template <typename T>
+    T &add(Entity entity, const T &component = T()) { return pool<T>().add(entity, component); }
+    template <typename T>
+    void remove(Entity entity) { pool<T>().remove(entity); }
+    template <typename T>
+    bool has(Entity entity) { return pool<T>().has(entity); }
+    template <typename T>
+    T &get(Entity entity) { return pool<T>().get(entity); }
+
+    // Pack entities owning both A and B into the front of both pools in the same order
+    // so systems can walk the two dense arrays side by side without sparse lookups
+    // Returns the number of packed entities, repacks only after structural changes
+    // A pool can only be packed by one group, two groups sharing a pool undo each other's
+    // order and repack on every call, use each<T>() with get() lookups for the other system
+    template <typename A, typename B>
+    size_t group() {
+        ComponentPool<A> &a = pool<A>();
+        ComponentPool<B> &b = pool<B>();
+        std::pair<size_t, size_t> key(componentId<A>(), componentId<B>());
+        std::map<std::pair<size_t, size_t>, GroupCache>::iterator cached = groups.find(key);
+        if (cached != groups.end() && cached->second.versionA == a.getVersion() &&
+            cached->second.versionB == b.getVersion()) {
+            return cached->second.size;
+        }
+
+        uint32_t packed = 0;
+        for (uint32_t slot = 0; slot < a.size(); slot++) {
+            Entity entity = a.entityData()[slot];
+            if (b.has(entity)) {
+                a.swapSlots(slot, packed);
+                b.swapSlots(b.slotOf(entity), packed);
+                packed++;
+            }
+        }
+        GroupCache cache = {a.getVersion(), b.getVersion(), packed};
+        groups[key] = cache;
+        return packed;
+    }
+
+    // Serial iteration over every entity with component T
+    template <typename T, typename Fn>
+    void each(Fn fn) {
+        ComponentPool<T> &p = pool<T>();
+        for (size_t i = 0; i < p.size(); i++) {
+            fn(p.entityData()[i], p.data()[i]);
+        }
+    }
+
+    // Serial iteration over entities with both A and B
+    template <typename A, typename B, typename Fn>
+    void each(Fn fn) {
+        size_t count = group<A, B>();
+        ComponentPool<A> &a = pool<A>();
+        ComponentPool<B> &b = pool<B>();
+        for (size_t i = 0; i < count; i++) {
+            fn(a.entityData()[i], a.data()[i], b.data()[i]);
+        }
+    }
+
+    // Parallel batches over the dense array of T, fn(T *components, size_t count)
+    template <typename T, typename Fn>
+    void parallelForEach(Fn fn) {
+        T *components = pool<T>().data();
+        parallelFor(pool<T>().size(), [&](size_t begin, size_t end) {
+            fn(components + begin, end - begin);
+        });
+    }
+
+    // Parallel batches over the packed A/B group, fn(A *a, B *b, size_t count)
+    template <typename A, typename B, typename Fn>
+    void parallelForEach(Fn fn) {
+        size_t count = group<A, B>();
+        A *a = pool<A>().data();
+        B *b = pool<B>().data();
+        parallelFor(count, [&](size_t begin, size_t end) {
+            fn(a + begin, b + begin, end - begin);
+        });
+    }
+};
+
+#endif // ECS_H
@@ -0,0 +1,284 @@
+#include "FrameCapture.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+FrameCapture::FrameCapture(ResourceManager &resources)
+    : nextSlot(0), resources(&resources), active(false), format(CaptureFormat::PNG), frameNumber(0),
+      stopping(false), rawWidth(0), rawHeight(0), rawSegment(0), framesWritten(0), framesFailed(0),
+      framesDropped(0), lastCaptureMs(0.0f) {
+    for (int i = 0; i < RING_SIZE; i++) {
+        slots[i].pbo = 0;
+        slots[i].fence = 0;
+        slots[i].width = 0;
+        slots[i].height = 0;
+        slots[i].frame = 0;
+    }
+}
+
+FrameCapture::~FrameCapture() {
+    // PBOs need the context, stop() is expected before it goes away, only the worker is left here
+    if (worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+}
+
+void FrameCapture::start(const std::string &outputDirectory, CaptureFormat captureFormat) {
+    if (active) {
+        return;
+    }
+#ifdef _WIN32
+    _mkdir(outputDirectory.c_str());
+#else
+    mkdir(outputDirectory.c_str(), 0755);
+#endif
+    directory = outputDirectory;
+    format = captureFormat;
+    frameNumber = 0;
+    framesDropped = 0;
+    rawWidth = 0;
+    rawHeight = 0;
+    rawSegment = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        framesWritten = 0;
+        framesFailed = 0;
+        stopping = false;
+    }
+    worker = std::thread(&FrameCapture::workerLoop, this);
+    active = true;
+}
+
+void FrameCapture::stop() {
+    if (!active) {
+        return;
+    }
+    collect(true);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+    if (rawFile.is_open()) {
+        rawFile.close();
+    }
+
+    for (int i = 0; i < RING_SIZE; i++) {
+        if (slots[i].pbo) {
+            resources->releaseBuffer(slots[i].pbo);
+        }
+        slots[i].pbo = 0;
+        slots[i].width = 0;
+        slots[i].height = 0;
+    }
+    nextSlot = 0;
+    freeBuffers.clear();
+    active = false;
+}
+
+void FrameCapture::captureFrame(int width, int height) {
+    if (!active) {
+        return;
+    }
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    collect(false);
+
+    Slot &slot = slots[nextSlot];
+    if (slot.fence) {
+        // The GPU hasn't finished the read from RING_SIZE frames ago, skip rather than stall
+        framesDropped++;
+    } else {
+        if (!slot.pbo || slot.width != width || slot.height != height) {
+            if (slot.pbo) {
+                resources->releaseBuffer(slot.pbo);
+            }
+            size_t bytes = static_cast<size_t>(width) * height * 4;
+            glGenBuffers(1, &slot.pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+            // Kept out of GLBuffers, whose budget would otherwise evict every cube mesh to fit a large frame
+            resources->trackBuffer(slot.pbo, bytes, ResourceCategory::CaptureBuffers);
+            slot.width = width;
+            slot.height = height;
+        } else {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        }
+        // Returns straight away, the copy into the PBO happens on the GPU
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.frame = frameNumber;
+        nextSlot = (nextSlot + 1) % RING_SIZE;
+    }
+    frameNumber++;
+
+    lastCaptureMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void FrameCapture::collect(bool block) {
+    // Oldest read first so frames reach the worker in order
+    for (int i = 0; i < RING_SIZE; i++) {
+        Slot &slot = slots[(nextSlot + i) % RING_SIZE];
+        if (!slot.fence) {
+            continue;
+        }
+        GLenum status = block ? glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull)
+                              : glClientWaitSync(slot.fence, 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            readSlot(slot);
+        } else if (!block) {
+            // Anything newer won't be done either
+            return;
+        } else {
+            glDeleteSync(slot.fence);
+            slot.fence = 0;
+            framesDropped++;
+        }
+    }
+}
+
+void FrameCapture::readSlot(Slot &slot) {
+    glDeleteSync(slot.fence);
+    slot.fence = 0;
+
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.size() >= MAX_QUEUED_FRAMES) {
+            // Encoder is behind, drop instead of growing the queue
+            framesDropped++;
+            return;
+        }
+        if (!freeBuffers.empty()) {
+            job.pixels = std::move(freeBuffers.back());
+            freeBuffers.pop_back();
+        }
+    }
+
+    size_t rowBytes = static_cast<size_t>(slot.width) * 4;
+    size_t bytes = rowBytes * slot.height;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const uint8_t *data = static_cast<const uint8_t *>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT));
+    if (!data) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        framesDropped++;
+        return;
+    }
+    // GL rows start at the bottom, flip while copying out
+    job.pixels.resize(bytes);
+    for (int y = 0; y < slot.height; y++) {
+        std::memcpy(&job.pixels[y * rowBytes], data + (slot.height - 1 - y) * rowBytes, rowBytes);
+    }
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    job.width = slot.width;
+    job.height = slot.height;
+    job.frame = slot.frame;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void FrameCapture::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+        // Only leave once everything queued is written
+        if (jobs.empty()) {
+            return;
+        }
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+
+        lock.unlock();
+        bool written = writeFrame(job);
+        lock.lock();
+
+        if (written) {
+            framesWritten++;
+        } else {
+            framesFailed++;
+        }
+        freeBuffers.push_back(std::move(job.pixels));
+    }
+}
+
+bool FrameCapture::writeFrame(Job &job) {
+    char path[512];
+    if (format == CaptureFormat::Raw) {
+        // Raw video has no per frame size, so a resized frame can't go in the same file
+        if (job.width != rawWidth || job.height != rawHeight) {
+            if (rawFile.is_open()) {
+                rawFile.close();
+            }
+            rawFile.clear();
+            if (rawSegment == 0) {
+                snprintf(path, sizeof(path), "%s/frames_%dx%d.rgba", directory.c_str(), job.width, job.height);
+            } else {
+                snprintf(path, sizeof(path), "%s/frames_%dx%d_%d.rgba", directory.c_str(), job.width, job.height,
+                         rawSegment);
+            }
+            rawFile.open(path, std::ios::binary);
+            rawWidth = job.width;
+            rawHeight = job.height;
+            rawSegment++;
+            if (!rawFile.is_open()) {
+                std::cerr << "Failed to open " << path << std::endl;
+            }
+        }
+        // After a failed open or write, frames are dropped until the size changes
+        if (!rawFile.is_open()) {
+            return false;
+        }
+        rawFile.write(reinterpret_cast<const char *>(job.pixels.data()), job.pixels.size());
+        if (!rawFile) {
+            std::cerr << "Failed to write raw frame " << job.frame << std::endl;
+            rawFile.close();
+            return false;
+        }
+        return true;
+    }
+
+    snprintf(path, sizeof(path), "%s/frame_%06llu.png", directory.c_str(), static_cast<unsigned long long>(job.frame));
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormatFrom(job.pixels.data(), job.width, job.height, 32,
+                                                              job.width * 4, SDL_PIXELFORMAT_RGBA32);
+    if (!surface) {
+        std::cerr << "Capture surface failed: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    bool written = IMG_SavePNG(surface, path) == 0;
+    if (!written) {
+        std::cerr << "Failed to write " << path << ": " << SDL_GetError() << std::endl;
+    }
+    SDL_FreeSurface(surface);
+    return written;
+}
+
+size_t FrameCapture::getFramesWritten() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return framesWritten;
+}
+
+size_t FrameCapture::getFramesDropped() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return framesDropped + framesFailed;
+}
@@ -0,0 +1,100 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <GL/glew.h>
+#include "ResourceManager.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class CaptureFormat {
+    // One numbered PNG per frame, for golden frame comparisons
+    PNG,
+    // Every frame appended top down to one raw RGBA file, for recording sessions
+    // A resize starts a new file, frames_WxH_N.rgba where N counts the files before it
+    // Encode with ffmpeg -f rawvideo -pix_fmt rgba -s WxH -i frames_WxH.rgba out.mp4
+    Raw
+};
+
+// Non blocking frame readback through a ring of pixel buffer objects
+// Each frame's glReadPixels goes into a PBO with a fence, the PBO is mapped a few frames
+// later once the fence has signaled, and encoding happens on a worker thread
+class FrameCapture {
+private:
+    static const int RING_SIZE = 3;
+    // Frames waiting for the worker before new ones get dropped instead of queued
+    static const size_t MAX_QUEUED_FRAMES = 8;
+
+    struct Slot {
+        GLuint pbo;
+        GLsync fence;
+        int width, height;
+        uint64_t frame;
+    };
+    Slot slots[RING_SIZE];
+    int nextSlot;
+
+    struct Job {
+        std::vector<uint8_t> pixels;
+        int width, height;
+        uint64_t frame;
+    };
+
+    ResourceManager *resources;
+    bool active;
+    CaptureFormat format;
+    std::string directory;
+    uint64_t frameNumber;
+
+    // Worker thread state, guarded by mutex
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Job> jobs;
+    std::vector<std::vector<uint8_t> > freeBuffers;
+    bool stopping;
+    // Only touched by the worker, and by start()/stop() while it isn't running
+    std::ofstream rawFile;
+    int rawWidth, rawHeight;
+    int rawSegment;
+
+    size_t framesWritten;
+    // Frames the worker couldn't write, guarded by mutex
+    size_t framesFailed;
+    // Frames skipped on the render thread
+    size_t framesDropped;
+    float lastCaptureMs;
+
+    // Map every slot whose fence has signaled, or wait for all of them when block is set
+    void collect(bool block);
+    void readSlot(Slot &slot);
+    void workerLoop();
+    // Returns false if the frame couldn't be written
+    bool writeFrame(Job &job);
+
+public:
+    explicit FrameCapture(ResourceManager &resources);
+    ~FrameCapture();
+
+    void start(const std::string &outputDirectory, CaptureFormat captureFormat);
+    // Finishes every frame already read back, then releases the PBOs
+    void stop();
+    bool isActive() const { return active; }
+
+    // Call once the scene is drawn and before the buffer swap
+    void captureFrame(int width, int height);
+
+    size_t getFramesWritten();
+    // Skipped frames plus frames that failed to write
+    size_t getFramesDropped();
+    // CPU time the render thread spent in the last captureFrame()
+    float getLastCaptureMs() const { return lastCaptureMs; }
+};
+
+#endif // FRAME_CAPTURE_H
@@ -0,0 +1,94 @@
+#include "ImageDiff.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+
+// Loads any format SDL_image knows and converts it to tightly addressed RGBA
+static SDL_Surface *loadRgba(const std::string &path) {
+    SDL_Surface *loaded = IMG_Load(path.c_str());
+    if (!loaded) {
+        throw std::runtime_error("Failed to load " + path + ": " + SDL_GetError());
+    }
+    SDL_Surface *converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if (!converted) {
+        throw std::runtime_error("Failed to convert " + path + ": " + SDL_GetError());
+    }
+    return converted;
+}
+
+ImageDiffResult compareImages(const std::string &actualPath, const std::string &expectedPath, int tolerance,
+                              const std::string &diffPath) {
+    SDL_Surface *actual = loadRgba(actualPath);
+    SDL_Surface *expected = nullptr;
+    try {
+        expected = loadRgba(expectedPath);
+    } catch (...) {
+        SDL_FreeSurface(actual);
+        throw;
+    }
+    if (actual->w != expected->w || actual->h != expected->h) {
+        SDL_FreeSurface(actual);
+        SDL_FreeSurface(expected);
+        throw std::runtime_error("Image sizes differ: " + actualPath + " vs " + expectedPath);
+    }
+
+    ImageDiffResult result;
+    result.width = actual->w;
+    result.height = actual->h;
+    result.mismatchedPixels = 0;
+    result.maxChannelDelta = 0;
+    result.meanChannelDelta = 0.0;
+
+    SDL_Surface *diff = nullptr;
+    if (!diffPath.empty()) {
+        diff = SDL_CreateRGBSurfaceWithFormat(0, result.width, result.height, 32, SDL_PIXELFORMAT_RGBA32);
+    }
+
+    SDL_LockSurface(actual);
+    SDL_LockSurface(expected);
+    uint64_t deltaSum = 0;
+    for (int y = 0; y < result.height; y++) {
+        const uint8_t *a = static_cast<const uint8_t *>(actual->pixels) + y * actual->pitch;
+        const uint8_t *e = static_cast<const uint8_t *>(expected->pixels) + y * expected->pitch;
+        uint8_t *d = diff ? static_cast<uint8_t *>(diff->pixels) + y * diff->pitch : nullptr;
+        for (int x = 0; x < result.width; x++) {
+            int pixelDelta = 0;
+            for (int c = 0; c < 4; c++) {
+                int delta = std::abs(a[x * 4 + c] - e[x * 4 + c]);
+                pixelDelta = std::max(pixelDelta, delta);
+                deltaSum += delta;
+            }
+            result.maxChannelDelta = std::max(result.maxChannelDelta, pixelDelta);
+            bool mismatch = pixelDelta > tolerance;
+            if (mismatch) {
+                result.mismatchedPixels++;
+            }
+            if (d) {
+                uint8_t gray = static_cast<uint8_t>((e[x * 4] + e[x * 4 + 1] + e[x * 4 + 2]) / 12);
+                d[x * 4] = mismatch ? 255 : gray;
+                d[x * 4 + 1] = mismatch ? 0 : gray;
+                d[x * 4 + 2] = mismatch ? 0 : gray;
+                d[x * 4 + 3] = 255;
+            }
+        }
+    }
+    SDL_UnlockSurface(expected);
+    SDL_UnlockSurface(actual);
+
+    size_t channels = static_cast<size_t>(result.width) * result.height * 4;
+    if (channels > 0) {
+        result.meanChannelDelta = static_cast<double>(deltaSum) / channels;
+    }
+
+    if (diff) {
+        IMG_SavePNG(diff, diffPath.c_str());
+        SDL_FreeSurface(diff);
+    }
+    SDL_FreeSurface(actual);
+    SDL_FreeSurface(expected);
+    return result;
+}
@@ -0,0 +1,21 @@
+#ifndef IMAGE_DIFF_H
+#define IMAGE_DIFF_H
+
+#include <cstddef>
+#include <string>
+
+struct ImageDiffResult {
+    int width, height;
+    // Pixels with any channel further apart than the tolerance
+    size_t mismatchedPixels;
+    int maxChannelDelta;
+    double meanChannelDelta;
+};
+
+// Compares a captured frame against a golden one channel by channel
+// When diffPath is set, writes an image with mismatched pixels in red over a dimmed copy of the golden frame
+// Throws std::runtime_error if either image can't be loaded or the sizes differ
+ImageDiffResult compareImages(const std::string &actualPath, const std::string &expectedPath, int tolerance,
+                              const std::string &diffPath = "");
+
+#endif // IMAGE_DIFF_H
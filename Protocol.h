@@ -0,0 +1,127 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Client <-> server message types, first byte of every message
+enum MessageType : uint8_t {
+    // Client -> server
+    MSG_SUBSCRIBE = 1,     // f32 x, y, z camera, u8 radius in chunks
+    MSG_CAMERA = 2,        // f32 x, y, z
+    MSG_SET_BLOCK = 3,     // i32 x, y, z, u8 block
+    MSG_CHUNK_DROPPED = 4, // i32 cx, cy, cz, client evicted it, send it again when needed
+    // Server -> client
+    MSG_CHUNK_SNAPSHOT = 10, // i32 cx, cy, cz, varint size, run length encoded blocks
+    MSG_CHUNK_UNLOAD = 11,   // i32 cx, cy, cz
+    MSG_BLOCK_DELTAS = 12,   // i32 cx, cy, cz, varint count, count * (u16 index, u8 block)
+    MSG_SYNCED = 13          // initial snapshots for a subscribe are done
+};
+
+// Little endian message builder
+class ByteWriter {
+private:
+    std::vector<uint8_t> &out;
+
+public:
+    explicit ByteWriter(std::vector<uint8_t> &out) : out(out) {}
+
+    void u8(uint8_t v) { out.push_back(v); }
+    void u16(uint16_t v) {
+        out.push_back(static_cast<uint8_t>(v));
+        out.push_back(static_cast<uint8_t>(v >> 8));
+    }
+    void u32(uint32_t v) {
+        for (int i = 0; i < 4; i++) {
+            out.push_back(static_cast<uint8_t>(v >> (i * 8)));
+        }
+    }
+    void i32(int32_t v) { u32(static_cast<uint32_t>(v)); }
+    void f32(float v) {
+        uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        u32(bits);
+    }
+    // 7 bits per byte, high bit set while more bytes follow
+    void varint(uint32_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+    }
+    void bytes(const uint8_t *data, size_t size) { out.insert(out.end(), data, data + size); }
+};
+
+// Bounds checked reader, ok() turns false on the first overrun and stays false
+class ByteReader {
+private:
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    bool valid;
+
+    bool need(size_t n) {
+        if (!valid || size - pos < n) {
+            valid = false;
+            return false;
+        }
+        return true;
+    }
+
+public:
+    ByteReader(const uint8_t *data, size_t size) : data(data), size(size), pos(0), valid(true) {}
+
+    bool ok() const { return valid; }
+    size_t remaining() const { return size - pos; }
+    const uint8_t *current() const { return data + pos; }
+    void skip(size_t n) {
+        if (need(n)) {
+            pos += n;
+        }
+    }
+
+    uint8_t u8() { return need(1) ? data[pos++] : 0; }
+    uint16_t u16() {
+        if (!need(2)) {
+            return 0;
+        }
+        uint16_t v = static_cast<uint16_t>(data[pos] | (data[pos + 1] << 8));
+        pos += 2;
+        return v;
+    }
+    uint32_t u32() {
+        if (!need(4)) {
+            return 0;
+        }
+        uint32_t v = 0;
+        for (int i = 0; i < 4; i++) {
+            v |= static_cast<uint32_t>(data[pos + i]) << (i * 8);
+        }
+        pos += 4;
+        return v;
+    }
+    int32_t i32() { return static_cast<int32_t>(u32()); }
+    float f32() {
+        uint32_t bits = u32();
+        float v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+    uint32_t varint() {
+        uint32_t v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint8_t b = u8();
+            v |= static_cast<uint32_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) {
+                return v;
+            }
+        }
+        valid = false;
+        return 0;
+    }
+};
+
+#endif // PROTOCOL_H
@@ -0,0 +1,218 @@
+#include "ResourceManager.h"
+#include "imgui/imgui.h"
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+static const char *categoryNames[] = {"GL buffers", "Chunk data", "Capture buffers"};
+
+ResourceManager::ResourceManager() : frame(0), viewerPosition(0.0f) {
+    for (int i = 0; i < CATEGORY_COUNT; i++) {
+        usage[i].used = 0;
+        usage[i].peak = 0;
+        usage[i].budget = std::numeric_limits<size_t>::max();
+        usage[i].evictions = 0;
+        evictionOrders[i] = EvictionOrder::LeastRecentlyUsed;
+    }
+}
+
+void ResourceManager::setBudget(ResourceCategory category, size_t bytes) {
+    usage[static_cast<int>(category)].budget = bytes;
+}
+
+void ResourceManager::account(ResourceCategory category, long long bytes) {
+    Usage &u = usage[static_cast<int>(category)];
+    if (bytes < 0 && static_cast<size_t>(-bytes) > u.used) {
+        u.used = 0;
+    } else {
+        u.used += bytes;
+    }
+    u.peak = std::max(u.peak, u.used);
+}
+
+void ResourceManager::trackBuffer(GLuint buffer, size_t bytes, ResourceCategory category) {
+    TrackedBuffer tracked = {bytes, category};
+    buffers[buffer] = tracked;
+    account(category, static_cast<long long>(bytes));
+}
+
+void ResourceManager::releaseBuffer(GLuint buffer) {
+    if (buffer == 0) {
+        return;
+    }
+    std::unordered_map<GLuint, TrackedBuffer>::iterator it = buffers.find(buffer);
+    if (it != buffers.end()) {
+        account(it->second.category, -static_cast<long long>(it->second.bytes));
+        buffers.erase(it);
+    }
+    pendingBuffers.push_back(buffer);
+}
+
+void ResourceManager::releaseVertexArray(GLuint vertexArray) {
+    if (vertexArray != 0) {
+        pendingVertexArrays.push_back(vertexArray);
+    }
+}
+
+void ResourceManager::trackCpu(ResourceCategory category, size_t bytes) {
+    account(category, static_cast<long long>(bytes));
+}
+
+void ResourceManager::releaseCpu(ResourceCategory category, size_t bytes) {
+    account(category, -static_cast<long long>(bytes));
+}
+
+void ResourceManager::setEvictCallback(ResourceCategory category, std::function<void(uint32_t)> callback,
+                                       EvictionOrder order) {
+    evictCallbacks[static_cast<int>(category)] = callback;
+    evictionOrders[static_cast<int>(category)] = order;
+}
+
+void ResourceManager::registerEvictable(ResourceCategory category, uint32_t key, glm::vec3 position) {
+    std::vector<Evictable> &entries = evictables[static_cast<int>(category)];
+    if (key >= entries.size()) {
+        Evictable empty = {false, glm::vec3(0.0f), 0};
+        entries.resize(key + 1, empty);
+    }
+    Evictable &e = entries[key];
+    e.registered = true;
+    e.position = position;
+    e.lastUsedFrame = frame;
+}
+
+void ResourceManager::unregisterEvictable(ResourceCategory category, uint32_t key) {
+    std::vector<Evictable> &entries = evictables[static_cast<int>(category)];
+    if (key < entries.size()) {
+        entries[key].registered = false;
+    }
+}
+
+void ResourceManager::touch(ResourceCategory category, uint32_t key, glm::vec3 position) {
+    std::vector<Evictable> &entries = evictables[static_cast<int>(category)];
+    if (key < entries.size() && entries[key].registered) {
+        entries[key].position = position;
+        entries[key].lastUsedFrame = frame;
+    }
+}
+
+void ResourceManager::evict(ResourceCategory category, uint32_t key) {
+    int c = static_cast<int>(category);
+    usage[c].evictions++;
+    evictCallbacks[c](key);
+    // The owner should have unregistered itself, make sure it can't be picked again
+    evictables[c][key].registered = false;
+}
+
+long long ResourceManager::farthestEvictable(ResourceCategory category, float minDistance) const {
+    const std::vector<Evictable> &entries = evictables[static_cast<int>(category)];
+    long long best = -1;
+    float bestDistance = minDistance;
+    for (size_t key = 0; key < entries.size(); key++) {
+        const Evictable &e = entries[key];
+        if (!e.registered || e.lastUsedFrame == frame) {
+            continue;
+        }
+        float distance = glm::distance(e.position, viewerPosition);
+        if (distance > bestDistance) {
+            bestDistance = distance;
+            best = static_cast<long long>(key);
+        }
+    }
+    return best;
+}
+
+bool ResourceManager::reserve(ResourceCategory category, size_t bytes, glm::vec3 position) {
+    const Usage &u = usage[static_cast<int>(category)];
+    if (!isEnforced(category)) {
+        return true;
+    }
+    float distance = glm::distance(position, viewerPosition);
+    while (u.used + bytes > u.budget) {
+        long long victim = farthestEvictable(category, distance);
+        if (victim < 0) {
+            return false;
+        }
+        evict(category, static_cast<uint32_t>(victim));
+    }
+    return true;
+}
+
+void ResourceManager::enforceBudget(ResourceCategory category) {
+    Usage &u = usage[static_cast<int>(category)];
+    if (u.used <= u.budget || !isEnforced(category)) {
+        return;
+    }
+
+    const std::vector<Evictable> &entries = evictables[static_cast<int>(category)];
+    std::vector<std::pair<uint32_t, float> > candidates;
+    for (size_t key = 0; key < entries.size(); key++) {
+        const Evictable &e = entries[key];
+        if (e.registered) {
+            candidates.push_back(std::make_pair(static_cast<uint32_t>(key),
+                                                glm::distance(e.position, viewerPosition)));
+        }
+    }
+    bool byAge = evictionOrders[static_cast<int>(category)] == EvictionOrder::LeastRecentlyUsed;
+    std::sort(candidates.begin(), candidates.end(),
+              [&entries, byAge](const std::pair<uint32_t, float> &a, const std::pair<uint32_t, float> &b) {
+                  uint64_t usedA = entries[a.first].lastUsedFrame;
+                  uint64_t usedB = entries[b.first].lastUsedFrame;
+                  if (byAge && usedA != usedB) {
+                      return usedA < usedB;
+                  }
+                  return a.second > b.second;
+              });
+
+    for (size_t i = 0; i < candidates.size() && u.used > u.budget; i++) {
+        evict(category, candidates[i].first);
+    }
+}
+
+void ResourceManager::beginFrame(glm::vec3 viewer) {
+    frame++;
+    viewerPosition = viewer;
+}
+
+void ResourceManager::endFrame() {
+    for (int i = 0; i < CATEGORY_COUNT; i++) {
+        enforceBudget(static_cast<ResourceCategory>(i));
+    }
+    flushDeletes();
+}
+
+void ResourceManager::flushDeletes() {
+    if (!pendingVertexArrays.empty()) {
+        glDeleteVertexArrays(static_cast<GLsizei>(pendingVertexArrays.size()), pendingVertexArrays.data());
+        pendingVertexArrays.clear();
+    }
+    if (!pendingBuffers.empty()) {
+        glDeleteBuffers(static_cast<GLsizei>(pendingBuffers.size()), pendingBuffers.data());
+        pendingBuffers.clear();
+    }
+}
+
+void ResourceManager::drawDebugPanel() {
+    ImGui::Begin("Memory");
+    for (int i = 0; i < CATEGORY_COUNT; i++) {
+        const Usage &u = usage[i];
+        float usedMB = u.used / (1024.0f * 1024.0f);
+        float peakMB = u.peak / (1024.0f * 1024.0f);
+        if (u.budget == std::numeric_limits<size_t>::max()) {
+            ImGui::Text("%s: %.2f MB (peak %.2f MB, no budget)", categoryNames[i], usedMB, peakMB);
+            continue;
+        }
+        float budgetMB = u.budget / (1024.0f * 1024.0f);
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "%.2f / %.2f MB", usedMB, budgetMB);
+        if (evictCallbacks[i]) {
+            ImGui::Text("%s (peak %.2f MB, %zu evictions)", categoryNames[i], peakMB, u.evictions);
+        } else {
+            // Nothing in this category can be evicted, the budget is only a marker
+            ImGui::Text("%s (peak %.2f MB, display only)", categoryNames[i], peakMB);
+        }
+        ImGui::ProgressBar(budgetMB > 0.0f ? usedMB / budgetMB : 1.0f, ImVec2(-1.0f, 0.0f), overlay);
+    }
+    ImGui::Text("Pending deletes: %zu buffers, %zu vertex arrays", pendingBuffers.size(),
+                pendingVertexArrays.size());
+    ImGui::End();
+}
@@ -0,0 +1,107 @@
+#ifndef RESOURCE_MANAGER_H
+#define RESOURCE_MANAGER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+enum class ResourceCategory {
+    GLBuffers,
+    ChunkData,
+    // Frame capture readback buffers, shown but never budgeted since nothing else can make room for them
+    CaptureBuffers,
+    Count
+};
+
+// How a category picks what to evict once it's over budget
+enum class EvictionOrder {
+    // Least recently used first, farthest first among equally old
+    LeastRecentlyUsed,
+    // Farthest from the viewer first, for owners that aren't touched every frame
+    Farthest
+};
+
+// Accounts GL and CPU allocations against per category budgets
+// GL deletions are queued and issued together at the end of the frame
+// When a budget is exceeded evictables are dropped in the category's eviction order
+class ResourceManager {
+private:
+    static const int CATEGORY_COUNT = static_cast<int>(ResourceCategory::Count);
+
+    struct Usage {
+        size_t used;
+        size_t peak;
+        size_t budget;
+        size_t evictions;
+    };
+    Usage usage[CATEGORY_COUNT];
+
+    struct TrackedBuffer {
+        size_t bytes;
+        ResourceCategory category;
+    };
+    std::unordered_map<GLuint, TrackedBuffer> buffers;
+    std::vector<GLuint> pendingBuffers;
+    std::vector<GLuint> pendingVertexArrays;
+
+    // Something that can give its memory back, keyed by the owner's id within its category
+    struct Evictable {
+        bool registered;
+        glm::vec3 position;
+        uint64_t lastUsedFrame;
+    };
+    std::vector<Evictable> evictables[CATEGORY_COUNT];
+    std::function<void(uint32_t)> evictCallbacks[CATEGORY_COUNT];
+    EvictionOrder evictionOrders[CATEGORY_COUNT];
+
+    uint64_t frame;
+    glm::vec3 viewerPosition;
+
+    void account(ResourceCategory category, long long bytes);
+    void evict(ResourceCategory category, uint32_t key);
+    // Farthest evictable in the category not used this frame, -1 if none is farther than minDistance
+    long long farthestEvictable(ResourceCategory category, float minDistance) const;
+    void enforceBudget(ResourceCategory category);
+
+public:
+    ResourceManager();
+
+    void setBudget(ResourceCategory category, size_t bytes);
+    size_t getUsed(ResourceCategory category) const { return usage[static_cast<int>(category)].used; }
+    size_t getBudget(ResourceCategory category) const { return usage[static_cast<int>(category)].budget; }
+
+    // GL objects, releases are deferred to endFrame()
+    void trackBuffer(GLuint buffer, size_t bytes, ResourceCategory category = ResourceCategory::GLBuffers);
+    void releaseBuffer(GLuint buffer);
+    void releaseVertexArray(GLuint vertexArray);
+
+    // CPU side chunk memory
+    void trackCpu(ResourceCategory category, size_t bytes);
+    void releaseCpu(ResourceCategory category, size_t bytes);
+
+    // Eviction candidates, the category's callback is asked to free the memory owned by key
+    // A budget is only enforced for categories with a callback, the rest are display only
+    void setEvictCallback(ResourceCategory category, std::function<void(uint32_t)> callback,
+                          EvictionOrder order = EvictionOrder::LeastRecentlyUsed);
+    bool isEnforced(ResourceCategory category) const { return static_cast<bool>(evictCallbacks[static_cast<int>(category)]); }
+    void registerEvictable(ResourceCategory category, uint32_t key, glm::vec3 position);
+    void unregisterEvictable(ResourceCategory category, uint32_t key);
+    void touch(ResourceCategory category, uint32_t key, glm::vec3 position);
+
+    // Make room for bytes in category by evicting anything farther from the viewer than position
+    // Returns false if the budget can't fit it, the caller should skip the allocation
+    bool reserve(ResourceCategory category, size_t bytes, glm::vec3 position);
+
+    void beginFrame(glm::vec3 viewer);
+    // Enforce budgets and issue the batched deletions
+    void endFrame();
+    void flushDeletes();
+
+    void drawDebugPanel();
+};
+
+#endif // RESOURCE_MANAGER_H
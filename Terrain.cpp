@@ -0,0 +1,32 @@
+#include "Terrain.h"
+#include <cmath>
+
+double Terrain::easeInOutExpo(double x) {
+    if (x == 0.0) {
+        return 0.0;
+    } else if (x == 1.0) {
+        return 1.0;
+    } else if (x < 0.5) {
+        return std::pow(2, 20 * x - 10) / 2;
+    } else {
+        return (2 - std::pow(2, -20 * x + 10)) / 2;
+    }
+}
+
+int Terrain::heightAt(int z, int depth, double maxHeight) {
+    // Scale z to [0, 1], ease it, then scale to a noticeable height
+    double normalized = static_cast<double>(z) / (depth - 1);
+    return static_cast<int>(std::round(easeInOutExpo(normalized) * maxHeight));
+}
+
+void Terrain::generate(World &world, int width, int depth, double maxHeight) {
+    for (int z = 0; z < depth; z++) {
+        int height = heightAt(z, depth, maxHeight);
+        for (int x = 0; x < width; x++) {
+            for (int y = 0; y < height; y++) {
+                world.setBlock(x, y, -z, BLOCK_GROUND);
+            }
+            world.setBlock(x, height, -z, BLOCK_SURFACE);
+        }
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include "World.h"
+
+// Default terrain size in blocks
+const int TERRAIN_WIDTH = 80;
+const int TERRAIN_DEPTH = 80;
+const double TERRAIN_MAX_HEIGHT = 10.0;
+
+// Eased slope terrain, rises along -z
+class Terrain {
+public:
+    static double easeInOutExpo(double x);
+    // Surface height of a column z blocks into a terrain depth blocks deep
+    static int heightAt(int z, int depth, double maxHeight);
+    // Fill columns x in [0, width), z in (-depth, 0] with ground up to the surface block
+    static void generate(World &world, int width, int depth, double maxHeight);
+};
+
+#endif // TERRAIN_H
@@ -0,0 +1,180 @@
+#include "TransformSystem.h"
+#include <algorithm>
+
+const size_t TransformSystem::BATCH_SIZE;
+
+TransformSystem::TransformSystem() {}
+
+TransformHandle TransformSystem::create(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale) {
+    glm::vec3 angles = glm::radians(rotation);
+    glm::quat q = glm::angleAxis(angles.x, glm::vec3(1.0f, 0.0f, 0.0f)) *
+                  glm::angleAxis(angles.y, glm::vec3(0.0f, 1.0f, 0.0f)) *
+                  glm::angleAxis(angles.z, glm::vec3(0.0f, 0.0f, 1.0f));
+
+    TransformHandle handle;
+    if (!freeHandles.empty()) {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    } else {
+        handle = static_cast<TransformHandle>(worldMatrices.size());
+        posX.push_back(0.0f);
+        posY.push_back(0.0f);
+        posZ.push_back(0.0f);
+        rotX.push_back(0.0f);
+        rotY.push_back(0.0f);
+        rotZ.push_back(0.0f);
+        rotW.push_back(1.0f);
+        scaleX.push_back(1.0f);
+        scaleY.push_back(1.0f);
+        scaleZ.push_back(1.0f);
+        worldMatrices.push_back(glm::mat4(1.0f));
+        dirty.push_back(0);
+    }
+    posX[handle] = position.x;
+    posY[handle] = position.y;
+    posZ[handle] = position.z;
+    rotX[handle] = q.x;
+    rotY[handle] = q.y;
+    rotZ[handle] = q.z;
+    rotW[handle] = q.w;
+    scaleX[handle] = scale.x;
+    scaleY[handle] = scale.y;
+    scaleZ[handle] = scale.z;
+    markDirty(handle);
+    return handle;
+}
+
+void TransformSystem::markDirty(TransformHandle handle) {
+    if (!dirty[handle]) {
+        dirty[handle] = 1;
+        dirtyList.push_back(handle);
+    }
+}
+
+void TransformSystem::setPosition(TransformHandle handle, glm::vec3 position) {
+    if (posX[handle] == position.x && posY[handle] == position.y && posZ[handle] == position.z) {
+        return;
+    }
+    posX[handle] = position.x;
+    posY[handle] = position.y;
+    posZ[handle] = position.z;
+    markDirty(handle);
+}
+
+void TransformSystem::translate(TransformHandle handle, glm::vec3 offset) {
+    setPosition(handle, getPosition(handle) + offset);
+}
+
+void TransformSystem::rotate(TransformHandle handle, glm::vec3 degrees) {
+    glm::vec3 angles = glm::radians(degrees);
+    glm::quat delta = glm::angleAxis(angles.x, glm::vec3(1.0f, 0.0f, 0.0f)) *
+                      glm::angleAxis(angles.y, glm::vec3(0.0f, 1.0f, 0.0f)) *
+                      glm::angleAxis(angles.z, glm::vec3(0.0f, 0.0f, 1.0f));
+    glm::quat q = glm::normalize(getRotation(handle) * delta);
+    rotX[handle] = q.x;
+    rotY[handle] = q.y;
+    rotZ[handle] = q.z;
+    rotW[handle] = q.w;
+    markDirty(handle);
+}
+
+void TransformSystem::setScale(TransformHandle handle, glm::vec3 scale) {
+    if (scaleX[handle] == scale.x && scaleY[handle] == scale.y && scaleZ[handle] == scale.z) {
+        return;
+    }
+    scaleX[handle] = scale.x;
+    scaleY[handle] = scale.y;
+    scaleZ[handle] = scale.z;
+    markDirty(handle);
+}
+
+void TransformSystem::addScale(TransformHandle handle, glm::vec3 increment) {
+    setScale(handle, getScale(handle) + increment);
+}
+
+glm::vec3 TransformSystem::getPosition(TransformHandle handle) const {
+    return glm::vec3(posX[handle], posY[handle], posZ[handle]);
+}
+
+glm::quat TransformSystem::getRotation(TransformHandle handle) const {
+    return glm::quat(rotW[handle], rotX[handle], rotY[handle], rotZ[handle]);
+}
+
+glm::vec3 TransformSystem::getScale(TransformHandle handle) const {
+    return glm::vec3(scaleX[handle], scaleY[handle], scaleZ[handle]);
+}
+
+size_t TransformSystem::update() {
+    size_t count = dirtyList.size();
+    if (count == 0) {
+        return 0;
+    }
+    // Sorted handles keep the gathers and the matrix writes moving forward through memory
+    std::sort(dirtyList.begin(), dirtyList.end());
+    for (size_t i = 0; i < count; i += BATCH_SIZE) {
+        computeBatch(&dirtyList[i], std::min(BATCH_SIZE, count - i));
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        dirty[dirtyList[i]] = 0;
+    }
+    dirtyList.clear();
+    return count;
+}
+
+// T * R * S built straight from the quaternion, no trig
+// Inputs are gathered into small SoA arrays first so every loop below is a plain
+// per-lane float loop the compiler can vectorize
+void TransformSystem::computeBatch(const TransformHandle *handles, size_t count) {
+    float px[BATCH_SIZE], py[BATCH_SIZE], pz[BATCH_SIZE];
+    float qx[BATCH_SIZE], qy[BATCH_SIZE], qz[BATCH_SIZE], qw[BATCH_SIZE];
+    float sx[BATCH_SIZE], sy[BATCH_SIZE], sz[BATCH_SIZE];
+    for (size_t i = 0; i < count; i++) {
+        TransformHandle h = handles[i];
+        px[i] = posX[h];
+        py[i] = posY[h];
+        pz[i] = posZ[h];
+        qx[i] = rotX[h];
+        qy[i] = rotY[h];
+        qz[i] = rotZ[h];
+        qw[i] = rotW[h];
+        sx[i] = scaleX[h];
+        sy[i] = scaleY[h];
+        sz[i] = scaleZ[h];
+    }
+
+    // Column major, m[column * 4 + row]
+    float m[16][BATCH_SIZE];
+    for (size_t i = 0; i < count; i++) {
+        float xx = qx[i] * qx[i], yy = qy[i] * qy[i], zz = qz[i] * qz[i];
+        float xy = qx[i] * qy[i], xz = qx[i] * qz[i], yz = qy[i] * qz[i];
+        float wx = qw[i] * qx[i], wy = qw[i] * qy[i], wz = qw[i] * qz[i];
+
+        m[0][i] = (1.0f - 2.0f * (yy + zz)) * sx[i];
+        m[1][i] = 2.0f * (xy + wz) * sx[i];
+        m[2][i] = 2.0f * (xz - wy) * sx[i];
+        m[3][i] = 0.0f;
+
+        m[4][i] = 2.0f * (xy - wz) * sy[i];
+        m[5][i] = (1.0f - 2.0f * (xx + zz)) * sy[i];
+        m[6][i] = 2.0f * (yz + wx) * sy[i];
+        m[7][i] = 0.0f;
+
+        m[8][i] = 2.0f * (xz + wy) * sz[i];
+        m[9][i] = 2.0f * (yz - wx) * sz[i];
+        m[10][i] = (1.0f - 2.0f * (xx + yy)) * sz[i];
+        m[11][i] = 0.0f;
+
+        m[12][i] = px[i];
+        m[13][i] = py[i];
+        m[14][i] = pz[i];
+        m[15][i] = 1.0f;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        float *out = &worldMatrices[handles[i]][0][0];
+        for (int e = 0; e < 16; e++) {
+            out[e] = m[e][i];
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef TRANSFORM_SYSTEM_H
+#define TRANSFORM_SYSTEM_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+typedef uint32_t TransformHandle;
+
+// Position/rotation/scale for every object in SoA form with dirty flags
+// World matrices are cached in one contiguous array and only rebuilt for objects
+// that changed since the last update()
+class TransformSystem {
+private:
+    std::vector<float> posX, posY, posZ;
+    // Rotation as a unit quaternion
+    std::vector<float> rotX, rotY, rotZ, rotW;
+    std::vector<float> scaleX, scaleY, scaleZ;
+
+    std::vector<uint8_t> dirty;
+    std::vector<TransformHandle> dirtyList;
+    std::vector<glm::mat4> worldMatrices;
+    // Destroyed handles, reused by create() so the arrays don't grow with churn
+    std::vector<TransformHandle> freeHandles;
+
+    void markDirty(TransformHandle handle);
+    void computeBatch(const TransformHandle *handles, size_t count);
+
+public:
+    // Objects per vectorized batch
+    static const size_t BATCH_SIZE = 64;
+
+    TransformSystem();
+
+    // Rotation is given as Euler angles in degrees, applied X then Y then Z
+    TransformHandle create(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale);
+    void destroy(TransformHandle handle) { freeHandles.push_back(handle); }
+
+    void setPosition(TransformHandle handle, glm::vec3 position);
+    void translate(TransformHandle handle, glm::vec3 offset);
+    // Rotate about the object's local axes, Euler degrees
+    void rotate(TransformHandle handle, glm::vec3 degrees);
+    void setScale(TransformHandle handle, glm::vec3 scale);
+    void addScale(TransformHandle handle, glm::vec3 increment);
+
+    glm::vec3 getPosition(TransformHandle handle) const;
+    glm::quat getRotation(TransformHandle handle) const;
+    glm::vec3 getScale(TransformHandle handle) const;
+    const glm::mat4 &getWorldMatrix(TransformHandle handle) const { return worldMatrices[handle]; }
+
+    // Rebuild matrices for dirty objects, returns how many were recomputed
+    size_t update();
+
+    // Live transforms, data() also spans destroyed slots waiting for reuse
+    size_t size() const { return worldMatrices.size() - freeHandles.size(); }
+    const glm::mat4 *data() const { return worldMatrices.data(); }
+};
+
+#endif // TRANSFORM_SYSTEM_H
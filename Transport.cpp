@@ -0,0 +1,246 @@
+#include "Transport.h"
+#include "Protocol.h"
+#include <iostream>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#define CLOSE_SOCKET closesocket
+#define INVALID_HANDLE INVALID_SOCKET
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define CLOSE_SOCKET close
+#define INVALID_HANDLE -1
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// Anything bigger than this is a corrupt stream, not a chunk
+static const uint32_t MAX_MESSAGE_SIZE = 16 * 1024 * 1024;
+
+static bool initSockets() {
+#ifdef _WIN32
+    static bool started = false;
+    if (!started) {
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+            return false;
+        }
+        started = true;
+    }
+#endif
+    return true;
+}
+
+static bool wouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+static void setNonBlocking(SocketHandle socket) {
+#ifdef _WIN32
+    u_long mode = 1;
+    ioctlsocket(socket, FIONBIO, &mode);
+#else
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    // Small delta messages shouldn't wait on Nagle
+    int noDelay = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&noDelay), sizeof(noDelay));
+}
+
+// Loopback
+
+LoopbackTransport::LoopbackTransport(std::shared_ptr<Channel> inbox, std::shared_ptr<Channel> outbox)
+    : inbox(inbox), outbox(outbox) {}
+
+LoopbackTransport::~LoopbackTransport() {
+    std::lock_guard<std::mutex> lock(outbox->mutex);
+    outbox->closed = true;
+}
+
+void LoopbackTransport::createPair(std::unique_ptr<Transport> &a, std::unique_ptr<Transport> &b) {
+    std::shared_ptr<Channel> aToB = std::make_shared<Channel>();
+    std::shared_ptr<Channel> bToA = std::make_shared<Channel>();
+    a.reset(new LoopbackTransport(bToA, aToB));
+    b.reset(new LoopbackTransport(aToB, bToA));
+}
+
+bool LoopbackTransport::send(const std::vector<uint8_t> &message) {
+    std::lock_guard<std::mutex> lock(outbox->mutex);
+    outbox->messages.push_back(message);
+    bytesSent += message.size();
+    return true;
+}
+
+bool LoopbackTransport::receive(std::vector<uint8_t> &message) {
+    std::lock_guard<std::mutex> lock(inbox->mutex);
+    if (inbox->messages.empty()) {
+        return false;
+    }
+    message.swap(inbox->messages.front());
+    inbox->messages.pop_front();
+    bytesReceived += message.size();
+    return true;
+}
+
+bool LoopbackTransport::isOpen() const {
+    std::lock_guard<std::mutex> lock(inbox->mutex);
+    // Still open until the peer is gone and everything it sent has been read
+    return !inbox->closed || !inbox->messages.empty();
+}
+
+// Socket
+
+SocketTransport::SocketTransport(SocketHandle socket) : socket(socket), open(true) {
+    setNonBlocking(socket);
+}
+
+SocketTransport::~SocketTransport() {
+    CLOSE_SOCKET(socket);
+}
+
+std::unique_ptr<Transport> SocketTransport::connect(const std::string &host, int port) {
+    if (!initSockets()) {
+        std::cerr << "Socket startup failed" << std::endl;
+        return nullptr;
+    }
+    SocketHandle s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_HANDLE) {
+        std::cerr << "Socket creation failed" << std::endl;
+        return nullptr;
+    }
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    inet_pton(AF_INET, host.c_str(), &address.sin_addr);
+    if (::connect(s, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        std::cerr << "Could not connect to world server at " << host << ":" << port << std::endl;
+        CLOSE_SOCKET(s);
+        return nullptr;
+    }
+    return std::unique_ptr<Transport>(new SocketTransport(s));
+}
+
+void SocketTransport::flush() {
+    while (open && !sendBuffer.empty()) {
+        int sent = ::send(socket, reinterpret_cast<const char *>(sendBuffer.data()),
+                          static_cast<int>(sendBuffer.size()), MSG_NOSIGNAL);
+        if (sent <= 0) {
+            if (sent < 0 && wouldBlock()) {
+                return;
+            }
+            open = false;
+            return;
+        }
+        sendBuffer.erase(sendBuffer.begin(), sendBuffer.begin() + sent);
+    }
+}
+
+void SocketTransport::fill() {
+    uint8_t chunk[16 * 1024];
+    while (open) {
+        int received = ::recv(socket, reinterpret_cast<char *>(chunk), sizeof(chunk), 0);
+        if (received <= 0) {
+            if (received < 0 && wouldBlock()) {
+                return;
+            }
+            open = false;
+            return;
+        }
+        receiveBuffer.insert(receiveBuffer.end(), chunk, chunk + received);
+    }
+}
+
+bool SocketTransport::send(const std::vector<uint8_t> &message) {
+    if (!open) {
+        return false;
+    }
+    ByteWriter writer(sendBuffer);
+    writer.u32(static_cast<uint32_t>(message.size()));
+    writer.bytes(message.data(), message.size());
+    bytesSent += message.size();
+    flush();
+    return open;
+}
+
+bool SocketTransport::receive(std::vector<uint8_t> &message) {
+    flush();
+    fill();
+    ByteReader reader(receiveBuffer.data(), receiveBuffer.size());
+    uint32_t size = reader.u32();
+    if (!reader.ok()) {
+        return false;
+    }
+    if (size > MAX_MESSAGE_SIZE) {
+        std::cerr << "Dropping connection, message of " << size << " bytes" << std::endl;
+        open = false;
+        return false;
+    }
+    if (reader.remaining() < size) {
+        return false;
+    }
+    message.assign(reader.current(), reader.current() + size);
+    receiveBuffer.erase(receiveBuffer.begin(), receiveBuffer.begin() + 4 + size);
+    bytesReceived += size;
+    return true;
+}
+
+// Listener
+
+SocketListener::SocketListener() : socket(INVALID_HANDLE), listening(false) {}
+
+SocketListener::~SocketListener() {
+    if (listening) {
+        CLOSE_SOCKET(socket);
+    }
+}
+
+bool SocketListener::listen(int port) {
+    if (!initSockets()) {
+        std::cerr << "Socket startup failed" << std::endl;
+        return false;
+    }
+    socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (socket == INVALID_HANDLE) {
+        std::cerr << "Socket creation failed" << std::endl;
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&reuse), sizeof(reuse));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        ::listen(socket, 8) != 0) {
+        std::cerr << "Could not listen on port " << port << std::endl;
+        CLOSE_SOCKET(socket);
+        return false;
+    }
+    setNonBlocking(socket);
+    listening = true;
+    return true;
+}
+
+std::unique_ptr<Transport> SocketListener::accept() {
+    if (!listening) {
+        return nullptr;
+    }
+    SocketHandle client = ::accept(socket, nullptr, nullptr);
+    if (client == INVALID_HANDLE) {
+        return nullptr;
+    }
+    return std::unique_ptr<Transport>(new SocketTransport(client));
+}
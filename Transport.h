@@ -0,0 +1,101 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef SOCKET SocketHandle;
+#else
+typedef int SocketHandle;
+#endif
+
+// Message oriented, non blocking link between a world server and a client
+class Transport {
+protected:
+    size_t bytesSent;
+    size_t bytesReceived;
+
+public:
+    Transport() : bytesSent(0), bytesReceived(0) {}
+    virtual ~Transport() {}
+
+    // Queue one whole message
+    virtual bool send(const std::vector<uint8_t> &message) = 0;
+    // Pop the next whole message if one has arrived, never blocks
+    virtual bool receive(std::vector<uint8_t> &message) = 0;
+    virtual bool isOpen() const = 0;
+
+    size_t getBytesSent() const { return bytesSent; }
+    size_t getBytesReceived() const { return bytesReceived; }
+};
+
+// In process pair of queues, safe to use from two threads
+class LoopbackTransport : public Transport {
+private:
+    struct Channel {
+        std::mutex mutex;
+        std::deque<std::vector<uint8_t> > messages;
+        bool closed;
+        Channel() : closed(false) {}
+    };
+    std::shared_ptr<Channel> inbox;
+    std::shared_ptr<Channel> outbox;
+
+    LoopbackTransport(std::shared_ptr<Channel> inbox, std::shared_ptr<Channel> outbox);
+
+public:
+    ~LoopbackTransport();
+
+    static void createPair(std::unique_ptr<Transport> &a, std::unique_ptr<Transport> &b);
+
+    bool send(const std::vector<uint8_t> &message);
+    bool receive(std::vector<uint8_t> &message);
+    bool isOpen() const;
+};
+
+// Length prefixed messages over a non blocking localhost TCP stream
+class SocketTransport : public Transport {
+private:
+    SocketHandle socket;
+    std::vector<uint8_t> sendBuffer;
+    std::vector<uint8_t> receiveBuffer;
+    bool open;
+
+    void flush();
+    void fill();
+
+public:
+    explicit SocketTransport(SocketHandle socket);
+    ~SocketTransport();
+
+    // nullptr if the connection couldn't be made
+    static std::unique_ptr<Transport> connect(const std::string &host, int port);
+
+    bool send(const std::vector<uint8_t> &message);
+    bool receive(std::vector<uint8_t> &message);
+    bool isOpen() const { return open; }
+};
+
+// Accepts SocketTransport connections on 127.0.0.1
+class SocketListener {
+private:
+    SocketHandle socket;
+    bool listening;
+
+public:
+    SocketListener();
+    ~SocketListener();
+
+    bool listen(int port);
+    // nullptr when nobody is waiting, never blocks
+    std::unique_ptr<Transport> accept();
+};
+
+#endif // TRANSPORT_H
@@ -0,0 +1,448 @@
+#include "VoxelOctree.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+const uint32_t VoxelOctree::LEAF;
+const size_t VoxelOctree::COMPACT_SLACK;
+
+size_t VoxelOctree::GroupKeyHash::operator()(const GroupKey &key) const {
+    size_t h = 14695981039346656037ull;
+    for (int i = 0; i < 8; i++) {
+        h = (h ^ key.children[i].firstChild) * 1099511628211ull;
+        h = (h ^ key.children[i].value) * 1099511628211ull;
+    }
+    return h;
+}
+
+bool VoxelOctree::GroupKeyEqual::operator()(const GroupKey &a, const GroupKey &b) const {
+    for (int i = 0; i < 8; i++) {
+        if (a.children[i].firstChild != b.children[i].firstChild || a.children[i].value != b.children[i].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+VoxelOctree::VoxelOctree() : originX(0), originY(0), originZ(0), size(0), sharedGroups(0), compactedSize(0) {}
+
+void VoxelOctree::clear() {
+    nodes.clear();
+    groups.clear();
+    size = 0;
+    sharedGroups = 0;
+    compactedSize = 0;
+}
+
+void VoxelOctree::build(const World &world) {
+    clear();
+    if (world.chunkCount() == 0) {
+        return;
+    }
+
+    // Chunk aligned bounds of everything in the world
+    int minC[3] = {std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
+    int maxC[3] = {std::numeric_limits<int>::min(), std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};
+    for (World::ChunkMap::const_iterator it = world.getChunks().begin(); it != world.getChunks().end(); ++it) {
+        const ChunkCoord &c = it->first;
+        minC[0] = std::min(minC[0], c.x);
+        minC[1] = std::min(minC[1], c.y);
+        minC[2] = std::min(minC[2], c.z);
+        maxC[0] = std::max(maxC[0], c.x);
+        maxC[1] = std::max(maxC[1], c.y);
+        maxC[2] = std::max(maxC[2], c.z);
+    }
+    int chunksAcross = std::max(maxC[0] - minC[0], std::max(maxC[1] - minC[1], maxC[2] - minC[2])) + 1;
+    size = CHUNK_SIZE;
+    while (size < chunksAcross * CHUNK_SIZE) {
+        size *= 2;
+    }
+    originX = minC[0] * CHUNK_SIZE;
+    originY = minC[1] * CHUNK_SIZE;
+    originZ = minC[2] * CHUNK_SIZE;
+
+    nodes.push_back(Node());
+    Node root = buildNode(world, originX, originY, originZ, size);
+    nodes[0] = root;
+    nodes.shrink_to_fit();
+    compactedSize = nodes.size();
+}
+
+VoxelOctree::Node VoxelOctree::buildNode(const World &world, int x, int y, int z, int nodeSize) {
+    Node leaf;
+    leaf.firstChild = LEAF;
+    leaf.value = BLOCK_AIR;
+
+    if (nodeSize <= CHUNK_SIZE) {
+        // Whole node sits inside one chunk since the root is chunk aligned
+        ChunkCoord coord = {chunkFloor(x), chunkFloor(y), chunkFloor(z)};
+        const Chunk *chunk = world.getChunk(coord);
+        if (!chunk || chunk->isEmpty()) {
+            return leaf;
+        }
+        if (nodeSize == 1) {
+            leaf.value = chunk->get(chunkLocal(x), chunkLocal(y), chunkLocal(z));
+            return leaf;
+        }
+    }
+
+    int half = nodeSize / 2;
+    GroupKey key;
+    for (int c = 0; c < 8; c++) {
+        key.children[c] = buildNode(world, x + half * (c & 1), y + half * ((c >> 1) & 1), z + half * ((c >> 2) & 1),
+                                    half);
+    }
+    return makeNode(key);
+}
+
+VoxelOctree::Node VoxelOctree::makeNode(const GroupKey &key) {
+    Node node;
+    node.value = BLOCK_AIR;
+    bool uniform = true;
+    for (int c = 0; c < 8; c++) {
+        const Node &child = key.children[c];
+        if (child.firstChild != LEAF || child.value != key.children[0].value) {
+            uniform = false;
+        }
+    }
+    if (uniform) {
+        node.firstChild = LEAF;
+        node.value = key.children[0].value;
+        return node;
+    }
+
+    GroupMap::const_iterator found = groups.find(key);
+    if (found != groups.end()) {
+        node.firstChild = found->second;
+        sharedGroups++;
+        return node;
+    }
+    node.firstChild = static_cast<uint32_t>(nodes.size());
+    nodes.insert(nodes.end(), key.children, key.children + 8);
+    groups[key] = node.firstChild;
+    return node;
+}
+
+void VoxelOctree::updateChunk(const World &world, ChunkCoord coord) {
+    int x = coord.x * CHUNK_SIZE;
+    int y = coord.y * CHUNK_SIZE;
+    int z = coord.z * CHUNK_SIZE;
+    if (nodes.empty()) {
+        // First chunk, the root starts out covering just it
+        Node air;
+        air.firstChild = LEAF;
+        air.value = BLOCK_AIR;
+        nodes.push_back(air);
+        originX = x;
+        originY = y;
+        originZ = z;
+        size = CHUNK_SIZE;
+        compactedSize = nodes.size();
+    }
+    while (!contains(x, y, z)) {
+        grow(x, y, z);
+    }
+    Node root = updateNode(world, nodes[0], originX, originY, originZ, size, x, y, z);
+    nodes[0] = root;
+
+    // Replaced groups pile up behind the live ones, reclaim them once they outnumber the tree
+    if (nodes.size() > compactedSize * 2 + COMPACT_SLACK) {
+        compact();
+    }
+}
+
+// node is taken by value since storing new groups can reallocate nodes
+VoxelOctree::Node VoxelOctree::updateNode(const World &world, Node node, int x, int y, int z, int nodeSize,
+                                          int targetX, int targetY, int targetZ) {
+    if (nodeSize == CHUNK_SIZE) {
+        return buildNode(world, x, y, z, nodeSize);
+    }
+    int half = nodeSize / 2;
+    GroupKey key;
+    for (int c = 0; c < 8; c++) {
+        key.children[c] = node.firstChild == LEAF ? node : nodes[node.firstChild + c];
+    }
+    int dx = targetX >= x + half;
+    int dy = targetY >= y + half;
+    int dz = targetZ >= z + half;
+    int c = dx | (dy << 1) | (dz << 2);
+    key.children[c] = updateNode(world, key.children[c], x + dx * half, y + dy * half, z + dz * half, half,
+                                 targetX, targetY, targetZ);
+    return makeNode(key);
+}
+
+void VoxelOctree::grow(int x, int y, int z) {
+    // The old root becomes the octant nearest the old origin side, the new root extends toward the target
+    int c = 0;
+    if (x < originX) {
+        originX -= size;
+        c |= 1;
+    }
+    if (y < originY) {
+        originY -= size;
+        c |= 2;
+    }
+    if (z < originZ) {
+        originZ -= size;
+        c |= 4;
+    }
+    GroupKey key;
+    for (int i = 0; i < 8; i++) {
+        key.children[i].firstChild = LEAF;
+        key.children[i].value = BLOCK_AIR;
+    }
+    key.children[c] = nodes[0];
+    size *= 2;
+    Node root = makeNode(key);
+    nodes[0] = root;
+}
+
+void VoxelOctree::compact() {
+    std::vector<Node> old;
+    old.swap(nodes);
+    groups.clear();
+    std::unordered_map<uint32_t, uint32_t> moved;
+    nodes.push_back(old[0]);
+    Node root = copyNode(old, old[0], moved);
+    nodes[0] = root;
+    nodes.shrink_to_fit();
+    compactedSize = nodes.size();
+}
+
+VoxelOctree::Node VoxelOctree::copyNode(const std::vector<Node> &old, Node node,
+                                        std::unordered_map<uint32_t, uint32_t> &moved) {
+    if (node.firstChild == LEAF) {
+        return node;
+    }
+    std::unordered_map<uint32_t, uint32_t>::const_iterator found = moved.find(node.firstChild);
+    if (found != moved.end()) {
+        node.firstChild = found->second;
+        return node;
+    }
+    GroupKey key;
+    for (int c = 0; c < 8; c++) {
+        key.children[c] = copyNode(old, old[node.firstChild + c], moved);
+    }
+    uint32_t first = static_cast<uint32_t>(nodes.size());
+    nodes.insert(nodes.end(), key.children, key.children + 8);
+    groups[key] = first;
+    moved[node.firstChild] = first;
+    node.firstChild = first;
+    return node;
+}
+
+bool VoxelOctree::contains(int x, int y, int z) const {
+    return !nodes.empty() && x >= originX && y >= originY && z >= originZ && x < originX + size &&
+           y < originY + size && z < originZ + size;
+}
+
+BlockId VoxelOctree::leafAt(int x, int y, int z, int &leafX, int &leafY, int &leafZ, int &leafSize) const {
+    const Node *node = &nodes[0];
+    leafX = originX;
+    leafY = originY;
+    leafZ = originZ;
+    leafSize = size;
+    while (node->firstChild != LEAF) {
+        leafSize /= 2;
+        int dx = x >= leafX + leafSize;
+        int dy = y >= leafY + leafSize;
+        int dz = z >= leafZ + leafSize;
+        leafX += dx * leafSize;
+        leafY += dy * leafSize;
+        leafZ += dz * leafSize;
+        node = &nodes[node->firstChild + (dx | (dy << 1) | (dz << 2))];
+    }
+    return node->value;
+}
+
+BlockId VoxelOctree::get(int x, int y, int z) const {
+    if (!contains(x, y, z)) {
+        return BLOCK_AIR;
+    }
+    int lx, ly, lz, ls;
+    return leafAt(x, y, z, lx, ly, lz, ls);
+}
+
+bool VoxelOctree::isRegionEmpty(int minX, int minY, int minZ, int maxX, int maxY, int maxZ) const {
+    if (nodes.empty()) {
+        return true;
+    }
+    int min[3] = {minX, minY, minZ};
+    int max[3] = {maxX, maxY, maxZ};
+    return regionUniform(nodes[0], originX, originY, originZ, size, min, max, false);
+}
+
+bool VoxelOctree::isRegionSolid(int minX, int minY, int minZ, int maxX, int maxY, int maxZ) const {
+    if (!contains(minX, minY, minZ) || !contains(maxX, maxY, maxZ)) {
+        return false;
+    }
+    int min[3] = {minX, minY, minZ};
+    int max[3] = {maxX, maxY, maxZ};
+    return regionUniform(nodes[0], originX, originY, originZ, size, min, max, true);
+}
+
+bool VoxelOctree::regionUniform(const Node &node, int x, int y, int z, int nodeSize, const int min[3],
+                                const int max[3], bool solid) const {
+    // No overlap with the query
+    if (x > max[0] || y > max[1] || z > max[2] || x + nodeSize <= min[0] || y + nodeSize <= min[1] ||
+        z + nodeSize <= min[2]) {
+        return true;
+    }
+    if (node.firstChild == LEAF) {
+        return (node.value != BLOCK_AIR) == solid;
+    }
+    int half = nodeSize / 2;
+    for (int c = 0; c < 8; c++) {
+        if (!regionUniform(nodes[node.firstChild + c], x + half * (c & 1), y + half * ((c >> 1) & 1),
+                           z + half * ((c >> 2) & 1), half, min, max, solid)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool VoxelOctree::highestSolid(int x, int z, int &y) const {
+    if (!contains(x, originY, z)) {
+        return false;
+    }
+    return highestSolid(nodes[0], originX, originY, originZ, size, x, z, y);
+}
+
+// Upper children first so the first solid leaf found is the highest
+bool VoxelOctree::highestSolid(const Node &node, int x, int y, int z, int nodeSize, int columnX, int columnZ,
+                               int &top) const {
+    if (node.firstChild == LEAF) {
+        if (node.value == BLOCK_AIR) {
+            return false;
+        }
+        top = y + nodeSize - 1;
+        return true;
+    }
+    int half = nodeSize / 2;
+    int dx = columnX >= x + half;
+    int dz = columnZ >= z + half;
+    for (int dy = 1; dy >= 0; dy--) {
+        if (highestSolid(nodes[node.firstChild + (dx | (dy << 1) | (dz << 2))], x + dx * half, y + dy * half,
+                         z + dz * half, half, columnX, columnZ, top)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VoxelOctree::raycast(const float origin[3], const float direction[3], float maxDistance, Hit &hit) const {
+    if (nodes.empty()) {
+        return false;
+    }
+    const float epsilon = 1e-4f;
+    const float infinity = std::numeric_limits<float>::infinity();
+    float rootMin[3] = {static_cast<float>(originX), static_cast<float>(originY), static_cast<float>(originZ)};
+
+    // Clip the ray to the root box
+    float t = 0.0f;
+    float tEnd = maxDistance;
+    for (int axis = 0; axis < 3; axis++) {
+        if (direction[axis] == 0.0f) {
+            if (origin[axis] < rootMin[axis] || origin[axis] >= rootMin[axis] + size) {
+                return false;
+            }
+            continue;
+        }
+        float t0 = (rootMin[axis] - origin[axis]) / direction[axis];
+        float t1 = (rootMin[axis] + size - origin[axis]) / direction[axis];
+        t = std::max(t, std::min(t0, t1));
+        tEnd = std::min(tEnd, std::max(t0, t1));
+    }
+
+    while (t <= tEnd) {
+        int voxel[3];
+        for (int axis = 0; axis < 3; axis++) {
+            voxel[axis] = static_cast<int>(std::floor(origin[axis] + direction[axis] * (t + epsilon)));
+        }
+        if (!contains(voxel[0], voxel[1], voxel[2])) {
+            return false;
+        }
+
+        int leaf[3], leafSize;
+        BlockId value = leafAt(voxel[0], voxel[1], voxel[2], leaf[0], leaf[1], leaf[2], leafSize);
+        if (value != BLOCK_AIR) {
+            hit.x = voxel[0];
+            hit.y = voxel[1];
+            hit.z = voxel[2];
+            float before = std::max(0.0f, t - epsilon);
+            hit.prevX = static_cast<int>(std::floor(origin[0] + direction[0] * before));
+            hit.prevY = static_cast<int>(std::floor(origin[1] + direction[1] * before));
+            hit.prevZ = static_cast<int>(std::floor(origin[2] + direction[2] * before));
+            hit.id = value;
+            hit.distance = t;
+            return true;
+        }
+
+        // Jump to where the ray leaves this empty leaf
+        float exit = infinity;
+        for (int axis = 0; axis < 3; axis++) {
+            if (direction[axis] > 0.0f) {
+                exit = std::min(exit, (leaf[axis] + leafSize - origin[axis]) / direction[axis]);
+            } else if (direction[axis] < 0.0f) {
+                exit = std::min(exit, (leaf[axis] - origin[axis]) / direction[axis]);
+            }
+        }
+        t = std::max(exit, t + epsilon);
+    }
+    return false;
+}
+
+uint64_t VoxelOctree::solidVoxels(const Node &node, int nodeSize) const {
+    if (node.firstChild == LEAF) {
+        return node.value == BLOCK_AIR ? 0 : static_cast<uint64_t>(nodeSize) * nodeSize * nodeSize;
+    }
+    uint64_t total = 0;
+    for (int c = 0; c < 8; c++) {
+        total += solidVoxels(nodes[node.firstChild + c], nodeSize / 2);
+    }
+    return total;
+}
+
+BlockId VoxelOctree::firstSolid(const Node &node) const {
+    if (node.firstChild == LEAF) {
+        return node.value;
+    }
+    for (int c = 0; c < 8; c++) {
+        BlockId id = firstSolid(nodes[node.firstChild + c]);
+        if (id != BLOCK_AIR) {
+            return id;
+        }
+    }
+    return BLOCK_AIR;
+}
+
+void VoxelOctree::collectSolidBoxes(int lodSize, std::vector<Box> &out) const {
+    if (!nodes.empty()) {
+        collectSolidBoxes(nodes[0], originX, originY, originZ, size, std::max(lodSize, 1), out);
+    }
+}
+
+void VoxelOctree::collectSolidBoxes(const Node &node, int x, int y, int z, int nodeSize, int lodSize,
+                                    std::vector<Box> &out) const {
+    Box box = {x, y, z, nodeSize, node.value};
+    if (node.firstChild == LEAF) {
+        if (node.value != BLOCK_AIR) {
+            out.push_back(box);
+        }
+        return;
+    }
+    if (nodeSize <= lodSize) {
+        // Coarse enough, keep it if at least half of it is solid
+        uint64_t volume = static_cast<uint64_t>(nodeSize) * nodeSize * nodeSize;
+        if (solidVoxels(node, nodeSize) * 2 >= volume) {
+            box.id = firstSolid(node);
+            out.push_back(box);
+        }
+        return;
+    }
+    int half = nodeSize / 2;
+    for (int c = 0; c < 8; c++) {
+        collectSolidBoxes(nodes[node.firstChild + c], x + half * (c & 1), y + half * ((c >> 1) & 1),
+                          z + half * ((c >> 2) & 1), half, lodSize, out);
+    }
+}
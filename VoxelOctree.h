@@ -0,0 +1,121 @@
+#ifndef VOXEL_OCTREE_H
+#define VOXEL_OCTREE_H
+
+#include "World.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Sparse voxel octree built from chunk data for far field storage and coarse queries
+// Uniform regions collapse into single leaves and identical child groups are shared (a DAG),
+// so large flat or empty areas cost a handful of nodes
+// Groups are never modified once stored, updateChunk() copies the path down to the chunk instead
+class VoxelOctree {
+public:
+    struct Hit {
+        int x, y, z;
+        // Last empty voxel before the hit, where a placed block would go
+        int prevX, prevY, prevZ;
+        BlockId id;
+        float distance;
+    };
+
+    // Axis aligned cube of blocks for coarse far terrain meshes
+    struct Box {
+        int x, y, z;
+        int size;
+        BlockId id;
+    };
+
+private:
+    static const uint32_t LEAF = 0xFFFFFFFF;
+
+    // Either a uniform leaf holding value, or 8 children stored contiguously from firstChild
+    // Child c covers origin + half * (c & 1, (c >> 1) & 1, (c >> 2) & 1)
+    struct Node {
+        uint32_t firstChild;
+        BlockId value;
+    };
+
+    // Build time lookup of child groups already stored, for sharing
+    struct GroupKey {
+        Node children[8];
+    };
+    struct GroupKeyHash {
+        size_t operator()(const GroupKey &key) const;
+    };
+    struct GroupKeyEqual {
+        bool operator()(const GroupKey &a, const GroupKey &b) const;
+    };
+    typedef std::unordered_map<GroupKey, uint32_t, GroupKeyHash, GroupKeyEqual> GroupMap;
+
+    // Groups left unreferenced by updates before compact() runs
+    static const size_t COMPACT_SLACK = 4096;
+
+    std::vector<Node> nodes;
+    // Every stored group, kept between builds so updates share subtrees too
+    GroupMap groups;
+    int originX, originY, originZ;
+    // Edge length of the root, a power of two and at least one chunk
+    int size;
+    size_t sharedGroups;
+    // Node count after the last build or compaction
+    size_t compactedSize;
+
+    Node buildNode(const World &world, int x, int y, int z, int nodeSize);
+    // Collapses uniform children into a leaf, otherwise stores the group or reuses an identical one
+    Node makeNode(const GroupKey &key);
+    Node updateNode(const World &world, Node node, int x, int y, int z, int nodeSize, int targetX, int targetY,
+                    int targetZ);
+    // Double the root toward a block outside it
+    void grow(int x, int y, int z);
+    // Drop groups no longer reachable from the root
+    void compact();
+    Node copyNode(const std::vector<Node> &old, Node node, std::unordered_map<uint32_t, uint32_t> &moved);
+    BlockId leafAt(int x, int y, int z, int &leafX, int &leafY, int &leafZ, int &leafSize) const;
+    // Every leaf overlapping the region is solid, or every one is air
+    bool regionUniform(const Node &node, int x, int y, int z, int nodeSize, const int min[3], const int max[3],
+                       bool solid) const;
+    bool highestSolid(const Node &node, int x, int y, int z, int nodeSize, int columnX, int columnZ, int &top) const;
+    uint64_t solidVoxels(const Node &node, int nodeSize) const;
+    BlockId firstSolid(const Node &node) const;
+    void collectSolidBoxes(const Node &node, int x, int y, int z, int nodeSize, int lodSize,
+                           std::vector<Box> &out) const;
+
+public:
+    VoxelOctree();
+
+    // Rebuild from every chunk in the world
+    void build(const World &world);
+    // Rebuild only the subtree of one chunk, growing the root if the chunk is outside it
+    // A chunk missing from the world becomes air
+    void updateChunk(const World &world, ChunkCoord coord);
+    void clear();
+
+    bool isEmpty() const { return nodes.empty(); }
+    bool contains(int x, int y, int z) const;
+
+    BlockId get(int x, int y, int z) const;
+    // Inclusive block bounds
+    bool isRegionEmpty(int minX, int minY, int minZ, int maxX, int maxY, int maxZ) const;
+    // Inclusive block bounds, anything outside the tree counts as air
+    bool isRegionSolid(int minX, int minY, int minZ, int maxX, int maxY, int maxZ) const;
+    // y of the highest solid block in the column, false if the column is empty
+    bool highestSolid(int x, int z, int &y) const;
+    // Steps leaf to leaf, so empty space is skipped a whole node at a time
+    bool raycast(const float origin[3], const float direction[3], float maxDistance, Hit &hit) const;
+
+    // Solid boxes no smaller than needed: nodes of lodSize or less become one box if mostly solid
+    void collectSolidBoxes(int lodSize, std::vector<Box> &out) const;
+
+    size_t nodeCount() const { return nodes.size(); }
+    // Nodes plus a rough size of the group lookup kept for updates
+    size_t memoryBytes() const {
+        return nodes.capacity() * sizeof(Node) + groups.size() * (sizeof(GroupKey) + sizeof(uint32_t) + 2 * sizeof(void *));
+    }
+    size_t getSharedGroups() const { return sharedGroups; }
+    int getSize() const { return size; }
+};
+
+#endif // VOXEL_OCTREE_H
@@ -0,0 +1,86 @@
+#include "World.h"
+#include <algorithm>
+
+World::World() : minChunkY(0), maxChunkY(-1) {}
+
+BlockId World::getBlock(int x, int y, int z) const {
+    ChunkCoord coord = {chunkFloor(x), chunkFloor(y), chunkFloor(z)};
+    const Chunk *chunk = getChunk(coord);
+    if (!chunk) {
+        return BLOCK_AIR;
+    }
+    return chunk->get(chunkLocal(x), chunkLocal(y), chunkLocal(z));
+}
+
+bool World::setBlock(int x, int y, int z, BlockId id) {
+    ChunkCoord coord = {chunkFloor(x), chunkFloor(y), chunkFloor(z)};
+    Chunk *chunk = getChunk(coord);
+    if (!chunk) {
+        // Don't allocate a chunk just to store air
+        if (id == BLOCK_AIR) {
+            return false;
+        }
+        chunk = &getOrCreateChunk(coord);
+    }
+    int i = Chunk::index(chunkLocal(x), chunkLocal(y), chunkLocal(z));
+    if (chunk->getIndex(i) == id) {
+        return false;
+    }
+    chunk->setIndex(i, id);
+    return true;
+}
+
+BlockId World::surfaceBlock(int x, int y, int z) const {
+    BlockId id = getBlock(x, y, z);
+    if (id == BLOCK_AIR || getBlock(x, y + 1, z) != BLOCK_AIR) {
+        return BLOCK_AIR;
+    }
+    return id;
+}
+
+Chunk *World::getChunk(ChunkCoord coord) {
+    ChunkMap::iterator it = chunks.find(coord);
+    return it == chunks.end() ? nullptr : it->second.get();
+}
+
+const Chunk *World::getChunk(ChunkCoord coord) const {
+    ChunkMap::const_iterator it = chunks.find(coord);
+    return it == chunks.end() ? nullptr : it->second.get();
+}
+
+Chunk &World::getOrCreateChunk(ChunkCoord coord) {
+    std::unique_ptr<Chunk> &slot = chunks[coord];
+    if (!slot) {
+        slot.reset(new Chunk());
+        if (maxChunkY < minChunkY) {
+            minChunkY = maxChunkY = coord.y;
+        } else {
+            minChunkY = std::min(minChunkY, coord.y);
+            maxChunkY = std::max(maxChunkY, coord.y);
+        }
+    }
+    return *slot;
+}
+
+void World::removeChunk(ChunkCoord coord) {
+    chunks.erase(coord);
+}
+
+bool World::highestSolid(int x, int z, int &y) const {
+    int lx = chunkLocal(x);
+    int lz = chunkLocal(z);
+    for (int cy = maxChunkY; cy >= minChunkY; cy--) {
+        ChunkCoord coord = {chunkFloor(x), cy, chunkFloor(z)};
+        const Chunk *chunk = getChunk(coord);
+        if (!chunk || chunk->isEmpty()) {
+            continue;
+        }
+        for (int ly = CHUNK_SIZE - 1; ly >= 0; ly--) {
+            if (chunk->get(lx, ly, lz) != BLOCK_AIR) {
+                y = cy * CHUNK_SIZE + ly;
+                return true;
+            }
+        }
+    }
+    return false;
+}
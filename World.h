@@ -0,0 +1,42 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include "Chunk.h"
+#include <memory>
+#include <unordered_map>
+
+// Sparse map of chunks addressed by world block coordinates
+// Used both as the server's authoritative world and the client's replica
+class World {
+public:
+    typedef std::unordered_map<ChunkCoord, std::unique_ptr<Chunk>, ChunkCoordHash> ChunkMap;
+
+private:
+    ChunkMap chunks;
+    // Vertical chunk range ever allocated, bounds column scans
+    int minChunkY;
+    int maxChunkY;
+
+public:
+    World();
+
+    BlockId getBlock(int x, int y, int z) const;
+    // Returns true if the stored block actually changed
+    bool setBlock(int x, int y, int z, BlockId id);
+
+    Chunk *getChunk(ChunkCoord coord);
+    const Chunk *getChunk(ChunkCoord coord) const;
+    Chunk &getOrCreateChunk(ChunkCoord coord);
+    void removeChunk(ChunkCoord coord);
+
+    // The block if it's solid with air above it, the blocks that get a cube, otherwise air
+    BlockId surfaceBlock(int x, int y, int z) const;
+
+    // y of the highest solid block in the column, false if the column is empty
+    bool highestSolid(int x, int z, int &y) const;
+
+    size_t chunkCount() const { return chunks.size(); }
+    const ChunkMap &getChunks() const { return chunks; }
+};
+
+#endif // WORLD_H
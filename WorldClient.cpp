@@ -0,0 +1,142 @@
+#include "WorldClient.h"
+#include "Protocol.h"
+#include <cmath>
+
+WorldClient::WorldClient(std::unique_ptr<Transport> transport)
+    : transport(std::move(transport)), synced(false) {
+    cameraChunk.x = cameraChunk.y = cameraChunk.z = 0;
+}
+
+void WorldClient::subscribe(float x, float y, float z, int radius) {
+    cameraChunk.x = chunkFloor(static_cast<int>(std::floor(x)));
+    cameraChunk.y = chunkFloor(static_cast<int>(std::floor(y)));
+    cameraChunk.z = chunkFloor(static_cast<int>(std::floor(z)));
+
+    std::vector<uint8_t> message;
+    ByteWriter writer(message);
+    writer.u8(MSG_SUBSCRIBE);
+    writer.f32(x);
+    writer.f32(y);
+    writer.f32(z);
+    writer.u8(static_cast<uint8_t>(radius));
+    transport->send(message);
+}
+
+void WorldClient::updateCamera(float x, float y, float z) {
+    ChunkCoord chunk = {chunkFloor(static_cast<int>(std::floor(x))), chunkFloor(static_cast<int>(std::floor(y))),
+                        chunkFloor(static_cast<int>(std::floor(z)))};
+    if (chunk == cameraChunk) {
+        return;
+    }
+    cameraChunk = chunk;
+
+    std::vector<uint8_t> message;
+    ByteWriter writer(message);
+    writer.u8(MSG_CAMERA);
+    writer.f32(x);
+    writer.f32(y);
+    writer.f32(z);
+    transport->send(message);
+}
+
+void WorldClient::requestSetBlock(int x, int y, int z, BlockId id) {
+    std::vector<uint8_t> message;
+    ByteWriter writer(message);
+    writer.u8(MSG_SET_BLOCK);
+    writer.i32(x);
+    writer.i32(y);
+    writer.i32(z);
+    writer.u8(id);
+    transport->send(message);
+}
+
+void WorldClient::evictChunk(ChunkCoord coord) {
+    world.removeChunk(coord);
+
+    std::vector<uint8_t> message;
+    ByteWriter writer(message);
+    writer.u8(MSG_CHUNK_DROPPED);
+    writer.i32(coord.x);
+    writer.i32(coord.y);
+    writer.i32(coord.z);
+    transport->send(message);
+}
+
+size_t WorldClient::poll() {
+    std::vector<uint8_t> message;
+    size_t handled = 0;
+    while (transport->receive(message)) {
+        handleMessage(message);
+        handled++;
+    }
+    return handled;
+}
+
+void WorldClient::handleMessage(const std::vector<uint8_t> &message) {
+    ByteReader reader(message.data(), message.size());
+    uint8_t type = reader.u8();
+    ChunkCoord coord = {0, 0, 0};
+    if (type == MSG_CHUNK_SNAPSHOT || type == MSG_CHUNK_UNLOAD || type == MSG_BLOCK_DELTAS) {
+        coord.x = reader.i32();
+        coord.y = reader.i32();
+        coord.z = reader.i32();
+    }
+
+    switch (type) {
+    case MSG_CHUNK_SNAPSHOT: {
+        uint32_t size = reader.varint();
+        if (!reader.ok() || reader.remaining() < size) {
+            return;
+        }
+        Chunk &chunk = world.getOrCreateChunk(coord);
+        ChunkEvent event = {coord, true};
+        if (!chunk.decompress(reader.current(), size)) {
+            world.removeChunk(coord);
+            event.loaded = false;
+        }
+        chunkEvents.push_back(event);
+        break;
+    }
+    case MSG_CHUNK_UNLOAD: {
+        world.removeChunk(coord);
+        ChunkEvent event = {coord, false};
+        chunkEvents.push_back(event);
+        break;
+    }
+    case MSG_BLOCK_DELTAS: {
+        uint32_t count = reader.varint();
+        Chunk *chunk = world.getChunk(coord);
+        for (uint32_t i = 0; i < count && reader.ok(); i++) {
+            uint16_t index = reader.u16();
+            BlockId id = reader.u8();
+            if (!reader.ok() || !chunk || index >= CHUNK_VOLUME) {
+                break;
+            }
+            chunk->setIndex(index, id);
+            // Back to world coordinates, index is x + z * size + y * size^2
+            BlockChange change;
+            change.x = coord.x * CHUNK_SIZE + index % CHUNK_SIZE;
+            change.z = coord.z * CHUNK_SIZE + (index / CHUNK_SIZE) % CHUNK_SIZE;
+            change.y = coord.y * CHUNK_SIZE + index / (CHUNK_SIZE * CHUNK_SIZE);
+            change.id = id;
+            changes.push_back(change);
+        }
+        break;
+    }
+    case MSG_SYNCED:
+        synced = true;
+        break;
+    default:
+        break;
+    }
+}
+
+void WorldClient::takeChanges(std::vector<BlockChange> &out) {
+    out.swap(changes);
+    changes.clear();
+}
+
+void WorldClient::takeChunkEvents(std::vector<ChunkEvent> &out) {
+    out.swap(chunkEvents);
+    chunkEvents.clear();
+}
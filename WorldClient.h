@@ -0,0 +1,62 @@
+#ifndef WORLD_CLIENT_H
+#define WORLD_CLIENT_H
+
+#include "Transport.h"
+#include "World.h"
+#include <memory>
+#include <vector>
+
+// Replica of the server's world around the camera
+class WorldClient {
+public:
+    struct BlockChange {
+        int x, y, z;
+        BlockId id;
+    };
+
+    // A chunk whose snapshot arrived (loaded) or that the server unloaded
+    struct ChunkEvent {
+        ChunkCoord coord;
+        bool loaded;
+    };
+
+private:
+    std::unique_ptr<Transport> transport;
+    World world;
+    ChunkCoord cameraChunk;
+    bool synced;
+    std::vector<BlockChange> changes;
+    std::vector<ChunkEvent> chunkEvents;
+
+    void handleMessage(const std::vector<uint8_t> &message);
+
+public:
+    explicit WorldClient(std::unique_ptr<Transport> transport);
+
+    void subscribe(float x, float y, float z, int radius);
+    // Only reaches the server when the camera crosses into another chunk
+    void updateCamera(float x, float y, float z);
+    void requestSetBlock(int x, int y, int z, BlockId id);
+
+    // Apply everything that has arrived, returns the number of messages handled
+    size_t poll();
+
+    // True once the snapshots for the first subscribe have all arrived
+    bool isSynced() const { return synced; }
+    bool isConnected() const { return transport->isOpen(); }
+    const World &getWorld() const { return world; }
+
+    // Blocks changed by deltas since the last call
+    void takeChanges(std::vector<BlockChange> &out);
+    // Snapshots and unloads since the last call, in arrival order
+    void takeChunkEvents(std::vector<ChunkEvent> &out);
+
+    // Drop a chunk from the replica to free memory and tell the server, which sends a fresh
+    // snapshot on the next edit to it or the next camera move that keeps it in range
+    void evictChunk(ChunkCoord coord);
+
+    size_t getBytesReceived() const { return transport->getBytesReceived(); }
+    size_t getBytesSent() const { return transport->getBytesSent(); }
+};
+
+#endif // WORLD_CLIENT_H
@@ -0,0 +1,203 @@
+#include "WorldServer.h"
+#include "Protocol.h"
+#include "Terrain.h"
+#include <cmath>
+#include <cstdlib>
+
+static ChunkCoord chunkOf(float x, float y, float z) {
+    ChunkCoord coord = {chunkFloor(static_cast<int>(std::floor(x))), chunkFloor(static_cast<int>(std::floor(y))),
+                        chunkFloor(static_cast<int>(std::floor(z)))};
+    return coord;
+}
+
+void WorldServer::generateTerrain(int width, int depth, double maxHeight) {
+    Terrain::generate(world, width, depth, maxHeight);
+}
+
+void WorldServer::addClient(std::unique_ptr<Transport> transport) {
+    std::unique_ptr<Client> client(new Client());
+    client->transport = std::move(transport);
+    client->subscribed = false;
+    client->center.x = client->center.y = client->center.z = 0;
+    client->radius = 0;
+    clients.push_back(std::move(client));
+}
+
+bool WorldServer::setBlock(int x, int y, int z, BlockId id) {
+    if (!world.setBlock(x, y, z, id)) {
+        return false;
+    }
+    ChunkCoord coord = {chunkFloor(x), chunkFloor(y), chunkFloor(z)};
+    uint16_t index = static_cast<uint16_t>(Chunk::index(chunkLocal(x), chunkLocal(y), chunkLocal(z)));
+    pendingDeltas[coord].push_back(std::make_pair(index, id));
+    return true;
+}
+
+void WorldServer::tick() {
+    std::vector<uint8_t> message;
+    for (size_t i = 0; i < clients.size(); i++) {
+        while (clients[i]->transport->receive(message)) {
+            handleMessage(*clients[i], message);
+        }
+    }
+
+    flushDeltas();
+
+    for (size_t i = 0; i < clients.size();) {
+        if (!clients[i]->transport->isOpen()) {
+            clients.erase(clients.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+void WorldServer::handleMessage(Client &client, const std::vector<uint8_t> &message) {
+    ByteReader reader(message.data(), message.size());
+    uint8_t type = reader.u8();
+    switch (type) {
+    case MSG_SUBSCRIBE: {
+        float x = reader.f32(), y = reader.f32(), z = reader.f32();
+        int radius = reader.u8();
+        if (!reader.ok()) {
+            return;
+        }
+        client.subscribed = true;
+        client.center = chunkOf(x, y, z);
+        client.radius = radius;
+        updateInterest(client);
+        std::vector<uint8_t> synced(1, MSG_SYNCED);
+        client.transport->send(synced);
+        break;
+    }
+    case MSG_CAMERA: {
+        float x = reader.f32(), y = reader.f32(), z = reader.f32();
+        if (!reader.ok() || !client.subscribed) {
+            return;
+        }
+        ChunkCoord center = chunkOf(x, y, z);
+        if (center != client.center) {
+            client.center = center;
+            updateInterest(client);
+        }
+        break;
+    }
+    case MSG_SET_BLOCK: {
+        int x = reader.i32(), y = reader.i32(), z = reader.i32();
+        BlockId id = reader.u8();
+        if (reader.ok()) {
+            setBlock(x, y, z, id);
+        }
+        break;
+    }
+    case MSG_CHUNK_DROPPED: {
+        ChunkCoord coord;
+        coord.x = reader.i32();
+        coord.y = reader.i32();
+        coord.z = reader.i32();
+        // Deltas sent before this arrived were ignored, a snapshot brings the client back in step
+        if (reader.ok()) {
+            client.loaded.erase(coord);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// Square column of chunks around the camera, every height
+bool WorldServer::inInterest(const Client &client, ChunkCoord coord) const {
+    return client.subscribed && std::abs(coord.x - client.center.x) <= client.radius &&
+           std::abs(coord.z - client.center.z) <= client.radius;
+}
+
+void WorldServer::updateInterest(Client &client) {
+    std::vector<ChunkCoord> leaving;
+    for (const ChunkCoord &coord : client.loaded) {
+        if (!inInterest(client, coord)) {
+            leaving.push_back(coord);
+        }
+    }
+    for (size_t i = 0; i < leaving.size(); i++) {
+        sendUnload(client, leaving[i]);
+    }
+
+    for (World::ChunkMap::const_iterator it = world.getChunks().begin(); it != world.getChunks().end(); ++it) {
+        if (inInterest(client, it->first) && !client.loaded.count(it->first)) {
+            sendSnapshot(client, it->first, *it->second);
+        }
+    }
+}
+
+void WorldServer::sendSnapshot(Client &client, ChunkCoord coord, const Chunk &chunk) {
+    std::vector<uint8_t> compressed;
+    chunk.compress(compressed);
+
+    std::vector<uint8_t> message;
+    ByteWriter writer(message);
+    writer.u8(MSG_CHUNK_SNAPSHOT);
+    writer.i32(coord.x);
+    writer.i32(coord.y);
+    writer.i32(coord.z);
+    writer.varint(static_cast<uint32_t>(compressed.size()));
+    writer.bytes(compressed.data(), compressed.size());
+    client.transport->send(message);
+    client.loaded.insert(coord);
+}
+
+void WorldServer::sendUnload(Client &client, ChunkCoord coord) {
+    std::vector<uint8_t> message;
+    ByteWriter writer(message);
+    writer.u8(MSG_CHUNK_UNLOAD);
+    writer.i32(coord.x);
+    writer.i32(coord.y);
+    writer.i32(coord.z);
+    client.transport->send(message);
+    client.loaded.erase(coord);
+}
+
+void WorldServer::flushDeltas() {
+    for (auto &entry : pendingDeltas) {
+        const ChunkCoord &coord = entry.first;
+        const std::vector<std::pair<uint16_t, BlockId> > &edits = entry.second;
+
+        std::vector<uint8_t> message;
+        ByteWriter writer(message);
+        writer.u8(MSG_BLOCK_DELTAS);
+        writer.i32(coord.x);
+        writer.i32(coord.y);
+        writer.i32(coord.z);
+        writer.varint(static_cast<uint32_t>(edits.size()));
+        for (size_t i = 0; i < edits.size(); i++) {
+            writer.u16(edits[i].first);
+            writer.u8(edits[i].second);
+        }
+
+        const Chunk *chunk = world.getChunk(coord);
+        for (size_t i = 0; i < clients.size(); i++) {
+            Client &client = *clients[i];
+            if (!inInterest(client, coord)) {
+                continue;
+            }
+            if (!client.loaded.count(coord)) {
+                if (!chunk) {
+                    continue;
+                }
+                // Edit created a chunk the client has never seen, send all of it first
+                // The deltas still follow so the client hears about the edited blocks
+                sendSnapshot(client, coord, *chunk);
+            }
+            client.transport->send(message);
+        }
+    }
+    pendingDeltas.clear();
+}
+
+size_t WorldServer::getBytesSent() const {
+    size_t total = 0;
+    for (size_t i = 0; i < clients.size(); i++) {
+        total += clients[i]->transport->getBytesSent();
+    }
+    return total;
+}
@@ -0,0 +1,52 @@
+#ifndef WORLD_SERVER_H
+#define WORLD_SERVER_H
+
+#include "Transport.h"
+#include "World.h"
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Authoritative world, replicates to clients over any Transport
+// Subscribing sends compressed snapshots of every chunk around the client's camera,
+// after that only per block deltas for edits and snapshots/unloads as the camera moves
+class WorldServer {
+private:
+    struct Client {
+        std::unique_ptr<Transport> transport;
+        bool subscribed;
+        ChunkCoord center;
+        int radius;
+        std::unordered_set<ChunkCoord, ChunkCoordHash> loaded;
+    };
+
+    World world;
+    std::vector<std::unique_ptr<Client> > clients;
+    // Edits since the last tick, (block index, new id) grouped by chunk
+    std::unordered_map<ChunkCoord, std::vector<std::pair<uint16_t, BlockId> >, ChunkCoordHash> pendingDeltas;
+
+    void handleMessage(Client &client, const std::vector<uint8_t> &message);
+    bool inInterest(const Client &client, ChunkCoord coord) const;
+    void updateInterest(Client &client);
+    void sendSnapshot(Client &client, ChunkCoord coord, const Chunk &chunk);
+    void sendUnload(Client &client, ChunkCoord coord);
+    void flushDeltas();
+
+public:
+    World &getWorld() { return world; }
+    void generateTerrain(int width, int depth, double maxHeight);
+
+    void addClient(std::unique_ptr<Transport> transport);
+    // Authoritative edit, replicated on the next tick
+    bool setBlock(int x, int y, int z, BlockId id);
+
+    // Handle client messages, send deltas and drop closed connections
+    void tick();
+
+    size_t getClientCount() const { return clients.size(); }
+    size_t getBytesSent() const;
+};
+
+#endif // WORLD_SERVER_H
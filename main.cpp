@@ -1,7 +1,9 @@
 #include "Application.h"
 
 #include "resource.h" //sounds
+#include "ImageDiff.h"
 
+#include <cstdlib>
 #include <string>
 
 // Pointers NULL
@@ -15,9 +17,90 @@ void framerate_cap(Uint32 frame, const int fps)
   }
 }
 
+// World simulation without a window, clients connect over localhost TCP
+int runHeadlessServer(int port, const int tickRate)
+{
+  WorldServer server;
+  server.generateTerrain(TERRAIN_WIDTH, TERRAIN_DEPTH, TERRAIN_MAX_HEIGHT);
+  SocketListener listener;
+  if (!listener.listen(port))
+  {
+    return 1;
+  }
+  std::cout << "World server listening on 127.0.0.1:" << port << std::endl;
+
+  while (true)
+  {
+    std::unique_ptr<Transport> connection = listener.accept();
+    while (connection)
+    {
+      std::cout << "Client connected" << std::endl;
+      server.addClient(std::move(connection));
+      connection = listener.accept();
+    }
+    server.tick();
+    SDL_Delay(1000 / tickRate);
+  }
+  return 0;
+}
+
+// Compares a captured frame with a golden one, exits non zero when any pixel is off by more than tolerance
+int runImageDiff(int argc, char *args[])
+{
+  if (argc < 4)
+  {
+    std::cerr << "Usage: --diff <actual.png> <expected.png> [tolerance] [diff.png]" << std::endl;
+    return 2;
+  }
+  int tolerance = argc > 4 ? std::atoi(args[4]) : 0;
+  std::string diffPath = argc > 5 ? args[5] : "";
+  try
+  {
+    ImageDiffResult result = compareImages(args[2], args[3], tolerance, diffPath);
+    std::cout << result.width << "x" << result.height << ": " << result.mismatchedPixels
+              << " pixels differ, max channel delta " << result.maxChannelDelta << ", mean "
+              << result.meanChannelDelta << std::endl;
+    return result.mismatchedPixels == 0 ? 0 : 1;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << e.what() << std::endl;
+    return 2;
+  }
+}
+
 int main(int argc, char *args[])
 {
+  if (argc > 1 && std::string(args[1]) == "--diff")
+  {
+    return runImageDiff(argc, args);
+  }
+
+  // --server <port> runs the world headless, --connect <port> renders a headless world
+  int serverPort = 0;
+  int connectPort = 0;
+  for (int i = 1; i + 1 < argc; i++)
+  {
+    std::string arg = args[i];
+    if (arg == "--server")
+    {
+      serverPort = std::atoi(args[i + 1]);
+    }
+    else if (arg == "--connect")
+    {
+      connectPort = std::atoi(args[i + 1]);
+    }
+  }
+  if (serverPort != 0)
+  {
+    return runHeadlessServer(serverPort, 20);
+  }
+
   app = new Application();
+  if (connectPort != 0)
+  {
+    app->connectTo(connectPort);
+  }
   app->init();
 
   Uint32 starting_tick;